@@ -97,6 +97,9 @@ void Commands::help() {
             << settings.num_terms << ")" << std::endl;
   std::cout << "  -b                   Print result in the OEIS b-file format"
             << std::endl;
+  std::cout << "  -r <file>            Checkpoint file for resuming b-file "
+               "generation (use with -b)"
+            << std::endl;
   std::cout << "  -o <string>          Export format "
                "(formula,loda,pari-function,pari-vector)"
             << std::endl;
@@ -241,7 +244,7 @@ void Commands::profile(const std::string& path) {
   Sequence res;
   Evaluator evaluator(settings);
   auto start_time = std::chrono::steady_clock::now();
-  evaluator.eval(program, res);
+  auto steps = evaluator.eval(program, res);
   auto cur_time = std::chrono::steady_clock::now();
   auto micro_secs = std::chrono::duration_cast<std::chrono::microseconds>(
                         cur_time - start_time)
@@ -256,6 +259,21 @@ void Commands::profile(const std::string& path) {
     std::cout << static_cast<double>(micro_secs) / 1000000.0 << "s"
               << std::endl;
   }
+  // compare measured and statically estimated steps
+  auto estimate = Analyzer::estimateSteps(program);
+  std::cout << "steps: " << steps.total;
+  if (estimate.growth.type == Growth::Type::UNKNOWN) {
+    std::cout << " (estimate: unknown)" << std::endl;
+  } else {
+    const int64_t offset = ProgramUtil::getOffset(program);
+    double total = 0;
+    for (size_t i = 0; i < res.size(); i++) {
+      total += estimate.evaluate(offset + i);
+    }
+    std::cout.precision(0);
+    std::cout << " (estimate: " << total << ", "
+              << estimate.growth.toString() << ")" << std::endl;
+  }
 }
 
 void Commands::fold(const std::string& main_path, const std::string& sub_id) {
@@ -121,6 +121,11 @@ int dispatch(Settings settings, const std::vector<std::string>& args) {
       cmd != "check") {
     Log::get().error("Option -b not allowed for this command", true);
   }
+  if (!settings.checkpoint_file.empty() &&
+      (!settings.print_as_b_file || (cmd != "evaluate" && cmd != "eval"))) {
+    Log::get().error("Option -r only allowed in evaluate command with -b",
+                     true);
+  }
   if (settings.parallel_mining && cmd != "mine") {
     Log::get().error("Option -p only allowed in mine command", true);
   }
@@ -128,6 +133,23 @@ int dispatch(Settings settings, const std::vector<std::string>& args) {
     Commands::help();
     return EXIT_SUCCESS;
   }
+  if (cmd == "mine" || cmd == "mutate") {
+    // share evaluated terms between miner processes and restarts
+    settings.use_term_store = Setup::getSetupFlag("LODA_USE_TERM_STORE", true);
+    // skip matching of recently processed output sequences
+    settings.use_output_cache =
+        Setup::getSetupFlag("LODA_USE_OUTPUT_CACHE", true);
+    settings.persist_output_cache =
+        Setup::getSetupFlag("LODA_PERSIST_OUTPUT_CACHE", false);
+    // match and check the memory cells of programs using multiple threads
+    settings.num_find_threads = Setup::getSetupInt("LODA_FIND_THREADS", 1);
+  }
+  if (cmd == "check" || cmd == "maintain") {
+    // evaluate long sequences using multiple threads
+    settings.num_eval_threads = Setup::getSetupInt(
+        "LODA_EVAL_THREADS",
+        std::max<int64_t>(std::thread::hardware_concurrency(), 1));
+  }
 
   Commands commands(settings);
 
@@ -1,27 +1,36 @@
 #include "cmd/test.hpp"
 
+#include <algorithm>
+#include <cstring>
 #include <deque>
 #include <fstream>
 #include <iomanip>
+#include <iterator>
 #include <sstream>
 #include <stdexcept>
 
 #include "eval/evaluator.hpp"
+#include "eval/evaluator_mat.hpp"
 #include "eval/interpreter.hpp"
 #include "eval/minimizer.hpp"
 #include "eval/optimizer.hpp"
 #include "eval/semantics.hpp"
+#include "eval/term_store.hpp"
 #include "form/formula_gen.hpp"
 #include "form/pari.hpp"
+#include "lang/analyzer.hpp"
 #include "lang/comments.hpp"
 #include "lang/constants.hpp"
 #include "lang/parser.hpp"
+#include "lang/program_store.hpp"
 #include "lang/program_util.hpp"
 #include "lang/subprogram.hpp"
 #include "math/big_number.hpp"
 #include "mine/api_client.hpp"
 #include "mine/blocks.hpp"
 #include "mine/config.hpp"
+#include "mine/finder.hpp"
+#include "mine/fingerprint_index.hpp"
 #include "mine/generator_v1.hpp"
 #include "mine/iterator.hpp"
 #include "mine/matcher.hpp"
@@ -29,6 +38,8 @@
 #include "mine/stats.hpp"
 #include "oeis/oeis_list.hpp"
 #include "oeis/oeis_manager.hpp"
+#include "oeis/oeis_program.hpp"
+#include "oeis/oeis_terms.hpp"
 #include "sys/file.hpp"
 #include "sys/git.hpp"
 #include "sys/log.hpp"
@@ -62,11 +73,30 @@ void Test::fast() {
   fold();
   unfold();
   incEval();
+  fingerprintIndex();
+  bloomFilter();
+  fusedReduction();
+  parallelFinder();
+  outputCache();
   linearMatcher();
   deltaMatcher();
   digitMatcher();
+  shiftMatcher();
   optimizer();
   checkpoint();
+  termStore();
+  programStore();
+  seqTerms();
+  recursion();
+  updatedCallee();
+  incEvalSeq();
+  matrixEval();
+  evalCheckpoint();
+  threadedEval();
+  prefixCache();
+  probeCheck();
+  stepEstimate();
+  trivialPrograms();
   knownPrograms();
   formula();
 }
@@ -853,6 +883,19 @@ bool Test::checkIncEval(const Settings& settings, size_t id, std::string path,
   if (steps_reg.total != steps_inc.total) {
     Log::get().error("Unexpected steps of " + msg, true);
   }
+  // check all memory cells using multi-sequence evaluation
+  std::vector<Sequence> cells_reg(10), cells_inc(10);
+  eval_reg.eval(p, cells_reg, seq_reg.size());
+  eval_inc.eval(p, cells_inc, seq_inc.size());
+  for (size_t i = 0; i < cells_reg.size(); i++) {
+    if (cells_reg[i] != cells_inc[i]) {
+      Log::get().info("Incremental eval result: " + cells_inc[i].to_string());
+      Log::get().info("Regular eval result:     " + cells_reg[i].to_string());
+      Log::get().error("Unexpected result of " + msg + " in cell $" +
+                           std::to_string(i),
+                       true);
+    }
+  }
   return true;
 }
 
@@ -887,6 +930,721 @@ void Test::checkpoint() {
   }
 }
 
+void Test::termStore() {
+  Log::get().info("Testing term store");
+  const std::string path = getTmpDir() + "loda_test_terms.bin";
+  const std::string index_path = getTmpDir() + "loda_test_terms.idx";
+  std::remove(path.c_str());
+  std::remove(index_path.c_str());
+  TermStore writer(path);
+  std::pair<Number, size_t> result;
+  writer.store(45, 123, 10, {55, 42});
+  writer.store(45, 123, 11, {89, 46});
+  writer.store(45, 123, 12, {Number("1000000000000000000000000"), 50});
+  // simulate access from other processes
+  TermStore reader(path, TermStore::MAX_RECORDS, std::chrono::milliseconds(0));
+  TermStore throttled(path, TermStore::MAX_RECORDS, std::chrono::hours(1));
+  if (!throttled.lookup(45, 123, 10, result) || result.first != Number(55)) {
+    Log::get().error("Unexpected term store lookup result", true);
+  }
+  if (!reader.lookup(45, 123, 11, result) || result.first != Number(89) ||
+      result.second != 46) {
+    Log::get().error("Unexpected term store lookup result", true);
+  }
+  if (reader.lookup(45, 124, 11, result)) {
+    Log::get().error("Expected invalidated term store entry", true);
+  }
+  if (reader.lookup(45, 123, 12, result)) {
+    Log::get().error("Unexpected big number in term store", true);
+  }
+  writer.store(45, 123, 13, {233, 54});
+  if (!reader.lookup(45, 123, 13, result) || result.first != Number(233)) {
+    Log::get().error("Expected appended term store entry", true);
+  }
+  if (throttled.lookup(45, 123, 13, result)) {
+    Log::get().error("Unexpected refresh of term store", true);
+  }
+  std::remove(path.c_str());
+  // records of old program versions are removed if the file is full
+  TermStore small(path, 8, std::chrono::milliseconds(0));
+  for (size_t hash : {1, 2, 3}) {
+    for (int64_t arg = 0; arg < 4; arg++) {
+      small.store(45, hash, arg, {arg, 1});
+    }
+  }
+  if (small.lookup(45, 1, 0, result) || !small.lookup(45, 2, 0, result) ||
+      !small.lookup(45, 3, 3, result) || result.first != Number(3)) {
+    Log::get().error("Unexpected term store compaction", true);
+  }
+  if (std::filesystem::file_size(path) != 8 * (sizeof(int64_t) * 5)) {
+    Log::get().error("Unexpected term store size after compaction", true);
+  }
+  std::remove(path.c_str());
+  std::remove(index_path.c_str());
+  // the index is shared if too many records are indexed per process
+  TermStore indexer(path, TermStore::MAX_RECORDS,
+                    std::chrono::milliseconds(0), 2);
+  for (int64_t arg = 0; arg < 5; arg++) {
+    indexer.store(45, 123, arg, {arg * arg, 1});
+  }
+  indexer.lookup(45, 123, 0, result);
+  TermStore shared(path, TermStore::MAX_RECORDS,
+                   std::chrono::milliseconds(0), 2);
+  if (!shared.lookup(45, 123, 4, result) || result.first != Number(16) ||
+      shared.getNumSharedRecords() != 5 || shared.getNumLocalRecords() != 0) {
+    Log::get().error("Unexpected shared term store index", true);
+  }
+  indexer.store(45, 123, 5, {25, 1});
+  if (!shared.lookup(45, 123, 5, result) || result.first != Number(25) ||
+      shared.getNumLocalRecords() != 1) {
+    Log::get().error("Expected locally indexed term store entry", true);
+  }
+  std::remove(path.c_str());
+  std::remove(index_path.c_str());
+}
+
+void Test::programStore() {
+  Log::get().info("Testing program store");
+  auto& store = ProgramStore::get();
+  auto p1 = store.getProgram(45);
+  auto p2 = store.getProgram(45);
+  if (p1 != p2) {
+    Log::get().error("Expected cached program in store", true);
+  }
+  Parser parser;
+  if (*p1 != parser.parse(ProgramUtil::getProgramPath(45))) {
+    Log::get().error("Unexpected program in store", true);
+  }
+  store.invalidate(45);
+  auto p3 = store.getProgram(45);
+  if (p3 == p1 || *p3 != *p1) {
+    Log::get().error("Expected reloaded program in store", true);
+  }
+  bool found = true;
+  try {
+    store.getProgram(999999);
+  } catch (const std::exception&) {
+    found = false;
+  }
+  if (found) {
+    Log::get().error("Unexpected program in store: A999999", true);
+  }
+  // simulate an update of a program file by another process
+  const auto path = ProgramUtil::getProgramPath(999998);
+  ensureDir(path);
+  std::ofstream(path) << "mov $0,1" << std::endl;
+  auto p4 = store.getProgram(999998);
+  std::ofstream(path) << "mov $0,22" << std::endl;
+  if (!store.refresh(true) || store.getProgram(999998) == p4 ||
+      *store.getProgram(999998) != parser.parse(path)) {
+    Log::get().error("Expected refreshed program in store", true);
+  }
+  if (store.refresh(true)) {
+    Log::get().error("Unexpected refresh of program store", true);
+  }
+
+  // load programs from a snapshot, unless their files were changed
+  const std::string snapshot = getTmpDir() + "loda_test_programs.bin";
+  store.setSnapshotPath(snapshot);
+  if (store.writeSnapshot({45, 999998, 999999, 45}) != 2) {
+    Log::get().error("Unexpected number of programs in snapshot", true);
+  }
+  store.clear();
+  const size_t num_loads = store.getNumSnapshotLoads();
+  if (*store.getProgram(45) != parser.parse(ProgramUtil::getProgramPath(45)) ||
+      store.getProgram(45)->ops.front().comment !=
+          parser.parse(ProgramUtil::getProgramPath(45)).ops.front().comment ||
+      store.getNumSnapshotLoads() != num_loads + 1) {
+    Log::get().error("Expected program from snapshot", true);
+  }
+  std::ofstream(path) << "mov $0,333" << std::endl;
+  store.clear();
+  if (*store.getProgram(999998) != parser.parse(path) ||
+      store.getNumSnapshotLoads() != num_loads + 1) {
+    Log::get().error("Unexpected outdated program from snapshot", true);
+  }
+  store.setSnapshotPath(Setup::getLodaHome() + "cache" + FILE_SEP +
+                        "programs_v1.bin");
+  std::filesystem::remove(snapshot);
+
+  std::filesystem::remove(path);
+  std::error_code ec;
+  std::filesystem::remove(std::filesystem::path(path).parent_path(), ec);
+  store.invalidate(999998);
+}
+
+void Test::seqTerms() {
+  Log::get().info("Testing seq terms provider");
+  // use wrong OEIS term at index 15 to limit the verified range
+  Sequence fib({0, 1, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144, 233, 377, 0});
+  std::vector<OeisSequence> sequences(1612);
+  sequences[45] = OeisSequence(45, "Fibonacci numbers", fib);
+  Sequence fib1;
+  for (size_t i = 0; i < 15; i++) {
+    fib1.push_back(Semantics::add(fib[i], Number::ONE));
+  }
+  sequences[1611] = OeisSequence(1611, "Fibonacci numbers + 1", fib1);
+  OeisTermsProvider provider(settings, sequences);
+  std::pair<Number, size_t> result;
+  if (!provider.getTerm(45, 14, result) || result.first != Number(377)) {
+    Log::get().error("Expected verified term of A000045", true);
+  }
+  if (provider.getTerm(45, 15, result)) {
+    Log::get().error("Unexpected unverified term of A000045", true);
+  }
+  std::stringstream buf("seq $0,45\nmul $0,2\n");
+  Parser parser;
+  auto p = parser.parse(buf);
+  Sequence expected, actual;
+  Evaluator evaluator(settings, false);
+  auto expected_steps = evaluator.eval(p, expected, 20);
+  Evaluator seeded(settings, false);
+  seeded.setSeqTermsProvider(&provider);
+  auto actual_steps = seeded.eval(p, actual, 20);
+  if (actual != expected || actual_steps.total != expected_steps.total) {
+    Log::get().error("Unexpected result using seq terms provider: " +
+                         actual.to_string() + " (" +
+                         std::to_string(actual_steps.total) + " steps)",
+                     true);
+  }
+  // the provider is used also for callees supported by incremental evaluation
+  class ConstantProvider : public SeqTermsProvider {
+   public:
+    bool getTerm(int64_t id, const Number& arg,
+                 std::pair<Number, size_t>& result) override {
+      result = {Number(7), 1};
+      return true;
+    }
+  };
+  ConstantProvider constant;
+  Evaluator inc_seeded(settings);
+  inc_seeded.setSeqTermsProvider(&constant);
+  inc_seeded.eval(p, actual, 5);
+  if (actual != Sequence({14, 14, 14, 14, 14})) {
+    Log::get().error("Expected terms of seq terms provider: " +
+                         actual.to_string(),
+                     true);
+  }
+  // entries of calling programs are invalidated together with the callee
+  if (!provider.getTerm(1611, 3, result) || result.first != Number(3) ||
+      provider.size() != 2) {
+    Log::get().error("Expected verified term of A001611", true);
+  }
+  provider.invalidate(45);
+  if (provider.size() != 0) {
+    Log::get().error("Expected invalidated entry of A001611", true);
+  }
+  provider.getTerm(1611, 3, result);
+  ProgramStore::get().clear();
+  provider.getTerm(45, 3, result);
+  if (provider.size() != 1) {
+    Log::get().error("Expected cleared seq terms provider", true);
+  }
+}
+
+void Test::recursion() {
+  Log::get().info("Testing recursion detection");
+  Evaluator evaluator(settings, false);
+  Parser parser;
+  // fill the caches with terms of A001611 and A000045
+  std::stringstream buf1("seq $0,1611\n");
+  auto p1 = parser.parse(buf1);
+  Sequence seq;
+  evaluator.eval(p1, seq, 10);
+  // A001611 calls A000045, so it must not be used in a program for A000045
+  std::stringstream buf2("seq $0,1611\nsub $0,1\n");
+  auto p2 = parser.parse(buf2);
+  Sequence fib({0, 1, 1, 2, 3, 5, 8, 13, 21, 34});
+  if (evaluator.check(p2, fib, -1, 45).first != status_t::ERROR) {
+    Log::get().error("Expected recursion error for A000045", true);
+  }
+  if (evaluator.check(p2, fib, -1, 1).first != status_t::OK) {
+    Log::get().error("Unexpected check result for A000001", true);
+  }
+}
+
+void Test::updatedCallee() {
+  Log::get().info("Testing update of called program");
+  const auto path = ProgramUtil::getProgramPath(999998);
+  ensureDir(path);
+  Parser parser;
+  std::stringstream buf("seq $0,999998\n");
+  auto p = parser.parse(buf);
+  Sequence doubled({0, 2, 4, 6, 8}), tripled({0, 3, 6, 9, 12});
+  Evaluator evaluator(settings, false);
+  if (evaluator.check(p, doubled).first != status_t::ERROR) {
+    Log::get().error("Unexpected check result for missing program", true);
+  }
+  // simulate an addition by another process after the refresh interval
+  std::ofstream(path) << "mul $0,2" << std::endl;
+  ProgramStore::get().refresh(true);
+  if (evaluator.check(p, doubled).first != status_t::OK) {
+    Log::get().error("Unexpected check result before update", true);
+  }
+  // simulate an update by another process after the refresh interval
+  std::ofstream(path) << "mul $0,3 ; updated" << std::endl;
+  ProgramStore::get().refresh(true);
+  if (evaluator.check(p, doubled).first != status_t::ERROR ||
+      evaluator.check(p, tripled).first != status_t::OK) {
+    Log::get().error("Unexpected check result after update", true);
+  }
+  std::filesystem::remove(path);
+  std::error_code ec;
+  std::filesystem::remove(std::filesystem::path(path).parent_path(), ec);
+  ProgramStore::get().invalidate(999998);
+}
+
+void Test::incEvalSeq() {
+  Log::get().info("Testing incremental evaluation of seq calls");
+  Parser parser;
+  auto callee = parser.parse(ProgramUtil::getProgramPath(45));
+  std::stringstream buf("seq $0,45\n");
+  auto p = parser.parse(buf);
+  // evaluate the called program regularly for every term
+  Interpreter interpreter(settings);
+  Sequence expected;
+  size_t expected_steps = 0;
+  for (int64_t i = 0; i < 30; i++) {
+    Memory mem;
+    mem.set(Program::INPUT_CELL, i);
+    expected_steps += interpreter.run(callee, mem) + 1;  // +1 for seq
+    expected.push_back(mem.get(Program::OUTPUT_CELL));
+  }
+  Evaluator evaluator(settings, false);
+  Sequence actual;
+  auto actual_steps = evaluator.eval(p, actual, 30);
+  if (actual != expected || actual_steps.total != expected_steps) {
+    Log::get().error("Unexpected result of seq calls: " + actual.to_string() +
+                         " (" + std::to_string(actual_steps.total) +
+                         " steps)",
+                     true);
+  }
+  // terms computed in advance are limited by the maximum number of steps
+  Memory mem;
+  mem.set(Program::INPUT_CELL, 900);
+  const size_t steps = interpreter.run(callee, mem);
+  const auto term = mem.get(Program::OUTPUT_CELL);
+  Settings limited(settings);
+  limited.max_cycles = steps + 10;
+  Interpreter limited_interpreter(limited);
+  std::stringstream buf2("mov $0,900\nseq $0,45\n");
+  auto p2 = parser.parse(buf2);
+  mem.clear();
+  if (limited_interpreter.run(p2, mem) != steps + 2 ||
+      mem.get(Program::OUTPUT_CELL) != term) {
+    Log::get().error("Unexpected result of seq call with limited steps", true);
+  }
+}
+
+void Test::matrixEval() {
+  std::vector<std::string> paths;
+  const std::string dir = std::string("tests") + FILE_SEP + "programs" +
+                          FILE_SEP + "oeis" + FILE_SEP;
+  for (const auto& f : std::filesystem::recursive_directory_iterator(dir)) {
+    if (f.path().extension() == ".asm") {
+      paths.push_back(f.path().string());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  std::vector<int64_t> args;
+  for (int64_t i = 0; i <= 40; i++) {
+    args.push_back(i);
+  }
+  args.push_back(500);
+  args.push_back(1000);
+  Parser parser;
+  Interpreter interpreter(settings);
+  MatrixEvaluator mat_evaluator(interpreter);
+  size_t num_supported = 0;
+  for (const auto& path : paths) {
+    auto p = parser.parse(path);
+    if (!mat_evaluator.init(p)) {
+      continue;
+    }
+    Log::get().info("Testing matrix evaluator for " + path);
+    num_supported++;
+    for (auto arg : args) {
+      Memory mem;
+      mem.set(Program::INPUT_CELL, arg);
+      std::pair<Number, size_t> expected, actual;
+      bool has_expected = true;
+      try {
+        expected.second = interpreter.run(p, mem);
+        expected.first = mem.get(Program::OUTPUT_CELL);
+      } catch (const std::exception&) {
+        has_expected = false;
+      }
+      bool has_actual;
+      try {
+        has_actual = mat_evaluator.eval(arg, actual);
+      } catch (const std::exception&) {
+        has_actual = false;
+      }
+      if (has_actual && (!has_expected || actual != expected)) {
+        Log::get().error("Unexpected result of matrix evaluator for " + path +
+                             " and argument " + std::to_string(arg) + ": " +
+                             actual.first.to_string() + " (" +
+                             std::to_string(actual.second) + " steps)",
+                         true);
+      }
+    }
+    // the evaluator uses it if incremental evaluation is disabled
+    const int64_t offset = ProgramUtil::getOffset(p);
+    Sequence expected_seq, actual_seq;
+    size_t expected_steps = 0;
+    for (int64_t i = 0; i < 150; i++) {
+      Memory mem;
+      mem.set(Program::INPUT_CELL, i + offset);
+      try {
+        expected_steps += interpreter.run(p, mem);
+      } catch (const std::exception&) {
+        break;
+      }
+      expected_seq.push_back(mem.get(Program::OUTPUT_CELL));
+    }
+    Evaluator evaluator(settings, false);
+    auto steps = evaluator.eval(p, actual_seq, 150, false);
+    if (actual_seq != expected_seq || steps.total != expected_steps ||
+        evaluator.check(p, expected_seq).first != status_t::OK) {
+      Log::get().error("Unexpected evaluation using matrix evaluator for " +
+                           path,
+                       true);
+    }
+  }
+  if (num_supported < 2) {
+    Log::get().error("Expected more programs supported by matrix evaluator",
+                     true);
+  }
+  // overflow in the first iteration only, which the interpreter detects
+  const std::string c = "1" + std::string(600, '0');
+  std::stringstream buf("mov $2,1\nlpb $0\nsub $0,1\nmov $1,$2\nmul $1," +
+                        c + "\nmul $1," + c +
+                        "\nmov $1,0\nmov $2,0\nlpe\nmov $0,$1\n");
+  auto p = parser.parse(buf);
+  std::pair<Number, size_t> result;
+  if (!mat_evaluator.init(p) || mat_evaluator.eval(5, result)) {
+    Log::get().error("Expected overflow in matrix evaluator", true);
+  }
+}
+
+void Test::evalCheckpoint() {
+  Log::get().info("Testing evaluation checkpoints");
+  std::vector<std::string> paths;
+  std::stringstream s;
+  for (size_t i = 1;; i++) {
+    s.str("");
+    s << "tests" << FILE_SEP << "inceval" << FILE_SEP << "I" << std::setw(3)
+      << std::setfill('0') << i << ".asm";
+    if (!isFile(s.str())) {
+      break;
+    }
+    paths.push_back(s.str());
+  }
+  paths.push_back(ProgramUtil::getProgramPath(5));  // not supported by IE
+  Settings checkpoint_settings(settings);
+  checkpoint_settings.checkpoint_file = getTmpDir() + "loda_checkpoint.txt";
+  Parser parser;
+  Sequence expected, first, second;
+  for (const auto& path : paths) {
+    auto p = parser.parse(path);
+    Evaluator evaluator(settings);
+    evaluator.eval(p, expected, 25);
+    std::remove(checkpoint_settings.checkpoint_file.c_str());
+    // evaluate the first terms, then resume using a new evaluator
+    Evaluator first_evaluator(checkpoint_settings);
+    first_evaluator.eval(p, first, 10);
+    Evaluator second_evaluator(checkpoint_settings);
+    second_evaluator.eval(p, second, 25);
+    for (size_t i = 0; i < 25; i++) {
+      const auto& got = (i < 10) ? first[i] : second[i];
+      if (got != expected[i]) {
+        Log::get().error("Unexpected term after resuming " + path + ": " +
+                             got.to_string() + " (expected " +
+                             expected[i].to_string() + ")",
+                         true);
+      }
+    }
+  }
+  // checkpoints of other programs must be rejected
+  bool rejected = false;
+  try {
+    Evaluator evaluator(checkpoint_settings);
+    evaluator.eval(parser.parse(ProgramUtil::getProgramPath(45)), first, 10);
+  } catch (const std::exception&) {
+    rejected = true;
+  }
+  std::remove(checkpoint_settings.checkpoint_file.c_str());
+  if (!rejected) {
+    Log::get().error("Checkpoint of different program not rejected", true);
+  }
+}
+
+void Test::prefixCache() {
+  Log::get().info("Testing prefix cache");
+  const std::string prefix = "mov $1,$0\nmul $1,3\nadd $1,2\nmov $2,$1\n";
+  const std::vector<std::string> programs = {
+      prefix + "lpb $0\n  add $3,$2\n  sub $0,1\nlpe\nmov $0,$3",
+      prefix + "lpb $0\n  add $3,$1\n  sub $0,1\nlpe\nmov $0,$3",
+      prefix + "pow $2,2\nlpb $0\n  add $3,$2\n  sub $0,1\nlpe",
+      "mov $1,$0\nmul $1,3\nadd $1,7\nlpb $1\n  sub $1,2\nlpe\nmov $0,$1",
+      prefix + "seq $2,45\nmov $0,$2",
+      "mov $1,$0\nmul $1,3\nadd $1,2\nmov $2,$1\nmov $0,$2",
+      "#offset 1\n" + prefix + "mov $0,$2",
+      prefix + "mov $0,$2"};
+  // incremental evaluation is disabled to compare the interpreter results
+  Evaluator cached_evaluator(settings, false);
+  Evaluator staged_evaluator(settings);
+  Parser parser;
+  for (size_t round = 0; round < 2; round++) {
+    for (const auto& program : programs) {
+      std::stringstream buf(program);
+      auto p = parser.parse(buf);
+      Evaluator evaluator(settings, false);
+      std::vector<Sequence> expected(5), got(5), staged(5);
+      auto expected_steps = evaluator.eval(p, expected, 20);
+      auto got_steps = cached_evaluator.eval(p, got, 20);
+      if (got != expected || got_steps.total != expected_steps.total ||
+          got_steps.max != expected_steps.max) {
+        Log::get().error("Unexpected result using prefix cache:\n" + program,
+                         true);
+      }
+      // continue the evaluation after the first terms
+      staged_evaluator.eval(p, staged, 4);
+      staged_evaluator.eval(p, staged, 20, 4);
+      if (staged != expected) {
+        Log::get().error("Unexpected result of staged evaluation:\n" + program,
+                         true);
+      }
+    }
+  }
+}
+
+void Test::threadedEval() {
+  Log::get().info("Testing threaded evaluation");
+  std::vector<std::string> paths;
+  const std::string dir = std::string("tests") + FILE_SEP + "programs" +
+                          FILE_SEP + "oeis" + FILE_SEP + "000" + FILE_SEP;
+  for (const auto& f : std::filesystem::directory_iterator(dir)) {
+    if (f.path().extension() == ".asm") {
+      paths.push_back(f.path().string());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  paths.resize(std::min<size_t>(paths.size(), 20));
+  const int64_t num_terms = 300;
+  Parser parser;
+  for (int64_t max_cycles : {Settings::DEFAULT_MAX_CYCLES, (int64_t)5000}) {
+    Settings seq_settings(settings);
+    seq_settings.max_cycles = max_cycles;
+    Settings thr_settings(seq_settings);
+    thr_settings.num_eval_threads = 4;
+    // incremental evaluation is disabled to compare the interpreter results
+    Evaluator seq_evaluator(seq_settings, false);
+    Evaluator thr_evaluator(thr_settings, false);
+    for (const auto& path : paths) {
+      auto p = parser.parse(path);
+      Sequence expected, got;
+      auto expected_steps = seq_evaluator.eval(p, expected, num_terms, false);
+      auto got_steps = thr_evaluator.eval(p, got, num_terms, false);
+      if (got != expected || got_steps.total != expected_steps.total ||
+          got_steps.runs != expected_steps.runs ||
+          got_steps.max != expected_steps.max) {
+        Log::get().error("Unexpected result of threaded evaluation of " + path,
+                         true);
+      }
+      // check with a wrong term to test the early exit
+      Sequence wrong = expected;
+      if (wrong.size() > 100) {
+        wrong[100] += Number::ONE;
+      }
+      for (const auto& s : {expected, wrong}) {
+        auto expected_result = seq_evaluator.check(p, s, 10);
+        auto got_result = thr_evaluator.check(p, s, 10);
+        if (got_result.first != expected_result.first ||
+            got_result.second.total != expected_result.second.total ||
+            got_result.second.runs != expected_result.second.runs) {
+          Log::get().error("Unexpected check result of threaded evaluation of " +
+                               path,
+                           true);
+        }
+      }
+    }
+  }
+}
+
+void Test::probeCheck() {
+  Log::get().info("Testing checks with probed terms");
+  std::vector<std::string> paths;
+  const std::string dir = std::string("tests") + FILE_SEP + "programs" +
+                          FILE_SEP + "oeis" + FILE_SEP;
+  for (const auto& f : std::filesystem::recursive_directory_iterator(dir)) {
+    if (f.path().extension() == ".asm") {
+      paths.push_back(f.path().string());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  const size_t num_terms = 100, num_required = 80;
+  Parser parser;
+  for (int64_t max_cycles : {(int64_t)100000, (int64_t)2000}) {
+    Settings check_settings(settings);
+    check_settings.max_cycles = max_cycles;
+    Interpreter interpreter(check_settings);
+    Evaluator evaluator(check_settings, false);
+    for (const auto& path : paths) {
+      auto p = parser.parse(path);
+      const int64_t offset = ProgramUtil::getOffset(p);
+      // reference terms and steps using sequential evaluation
+      Sequence terms;
+      std::vector<size_t> steps;
+      Memory mem;
+      for (size_t i = 0; i < num_terms; i++) {
+        try {
+          mem.clear();
+          mem.set(Program::INPUT_CELL, i + offset);
+          steps.push_back(interpreter.run(p, mem));
+          terms.push_back(mem.get(Program::OUTPUT_CELL));
+        } catch (const std::exception&) {
+          break;
+        }
+      }
+      // compare with the expected sequence and variants with wrong terms
+      for (size_t wrong : {num_terms, (size_t)3, (size_t)40, (size_t)79}) {
+        Sequence expected = terms;
+        if (wrong < terms.size()) {
+          expected[wrong] += Number::ONE;
+        } else {
+          expected.resize(num_terms, Number::ZERO);
+        }
+        status_t status = status_t::OK;
+        size_t total = 0;
+        for (size_t i = 0; i < expected.size(); i++) {
+          if (i >= terms.size()) {
+            status = (i >= num_required) ? status_t::WARNING : status_t::ERROR;
+            break;
+          }
+          total += steps[i];
+          if (terms[i] != expected[i]) {
+            status = status_t::ERROR;
+            break;
+          }
+        }
+        auto result = evaluator.check(p, expected, num_required);
+        if (result.first != status ||
+            (status != status_t::ERROR && result.second.total != total)) {
+          Log::get().error("Unexpected check result for " + path, true);
+        }
+      }
+    }
+  }
+}
+
+void Test::stepEstimate() {
+  Log::get().info("Testing step estimates");
+  std::vector<std::pair<std::string, std::string>> tests = {
+      {"mov $1,$0\nlpb $1\n  add $2,3\n  sub $1,1\nlpe\nmov $0,$2", "O(n)"},
+      {"lpb $0\n  mov $2,$0\n  lpb $2\n    add $1,1\n    sub $2,1\n  lpe\n"
+       "  sub $0,1\nlpe\nmov $0,$1",
+       "O(n^2)"},
+      {"lpb $0\n  add $1,1\n  div $0,2\nlpe\nmov $0,$1", "O(log(n))"},
+      {"mov $1,2\npow $1,$0\nlpb $1\n  add $2,1\n  sub $1,1\nlpe", "O(2^n)"},
+      {"lpb $0\n  mov $2,$0\n  seq $2,45\n  add $1,$2\n  sub $0,1\nlpe",
+       "O(n^2)"},
+      {"lpb $0\n  mov $0,$1\nlpe", "unknown"}};
+  Parser parser;
+  for (const auto& t : tests) {
+    std::stringstream buf(t.first);
+    auto p = parser.parse(buf);
+    auto estimate = Analyzer::estimateSteps(p);
+    if (estimate.growth.toString() != t.second) {
+      Log::get().error("Unexpected step estimate: " +
+                           estimate.growth.toString() + " (expected " +
+                           t.second + ")",
+                       true);
+    }
+    const bool exceeds =
+        estimate.exceeds(OeisSequence::DEFAULT_SEQ_LENGTH, settings.max_cycles);
+    if (exceeds != (t.second == "O(2^n)")) {
+      Log::get().error("Unexpected check of maximum cycles for " + t.second,
+                       true);
+    }
+  }
+  // the finder estimates the steps only if they can grow exponentially
+  Evaluator evaluator(settings, false);
+  Finder finder(settings, evaluator);
+  std::vector<OeisSequence> sequences;
+  Sequence norm_seq;
+  for (const auto& t : tests) {
+    std::stringstream buf(t.first);
+    finder.findSequence(parser.parse(buf), norm_seq, sequences);
+  }
+  const auto stats = finder.getStepEstimateStats(true);
+  if (stats.num_estimates != 3 || stats.num_skipped != 1 ||
+      finder.getStepEstimateStats(false).num_estimates != 0) {
+    Log::get().error("Unexpected step estimate statistics of finder", true);
+  }
+  // none of the test programs should exceed the maximum number of cycles
+  const std::string dir = std::string("tests") + FILE_SEP + "programs" +
+                          FILE_SEP + "oeis" + FILE_SEP;
+  for (const auto& f : std::filesystem::recursive_directory_iterator(dir)) {
+    if (f.path().extension() != ".asm") {
+      continue;
+    }
+    auto p = parser.parse(f.path().string());
+    const int64_t last_input = OeisProgram::getNumRequiredTerms(p) - 1 +
+                               ProgramUtil::getOffset(p);
+    if (Analyzer::estimateSteps(p).exceeds(last_input, settings.max_cycles)) {
+      Log::get().error("Unexpected step estimate for " + f.path().string(),
+                       true);
+    }
+  }
+}
+
+void Test::trivialPrograms() {
+  Log::get().info("Testing trivial programs");
+  std::vector<std::pair<std::string, bool>> tests = {
+      {"mov $1,5\nadd $1,$0", true},
+      {"mul $0,3\nsub $0,7\nmov $1,$0\nmul $1,-2", true},
+      {"mov $1,$0\nmov $0,4\npow $0,2", true},
+      {"mov $1,4\nlpb $1\n  add $2,3\n  sub $1,1\nlpe\nmov $0,$2", true},
+      {"mul $0,$0", false},
+      {"mov $1,$0\nlpb $1\n  add $2,3\n  sub $1,1\nlpe\nmov $0,$2", false},
+      {"mov $1,2\nlpb $1\n  add $2,$0\n  sub $1,1\nlpe\nmov $0,$2", false},
+      {"seq $0,45", false},
+      {"mov $1,$0\nclr $1,2", false}};
+  Parser parser;
+  for (const auto& t : tests) {
+    std::stringstream buf(t.first);
+    auto p = parser.parse(buf);
+    if (Analyzer::isTrivial(p) != t.second) {
+      Log::get().error("Unexpected triviality check for: " + t.first, true);
+    }
+  }
+  // trivial test programs must be affine functions
+  Evaluator evaluator(settings);
+  const std::string dir = std::string("tests") + FILE_SEP + "programs" +
+                          FILE_SEP + "oeis" + FILE_SEP;
+  for (const auto& f : std::filesystem::recursive_directory_iterator(dir)) {
+    if (f.path().extension() != ".asm") {
+      continue;
+    }
+    auto p = parser.parse(f.path().string());
+    if (!Analyzer::isTrivial(p)) {
+      continue;
+    }
+    Sequence seq;
+    evaluator.eval(p, seq, 10);
+    for (size_t i = 2; i < seq.size(); i++) {
+      auto d1 = seq[i], d2 = seq[i - 1];
+      d1 -= seq[i - 1];
+      d2 -= seq[i - 2];
+      if (d1 != d2) {
+        Log::get().error("Unexpected trivial program: " + f.path().string(),
+                         true);
+      }
+    }
+  }
+}
+
 void Test::steps() {
   auto file = ProgramUtil::getProgramPath(12);
   Log::get().info("Testing steps for " + file);
@@ -1324,6 +2082,352 @@ void Test::miner() {
   MultiGenerator multi_generator(settings, getManager().getStats(), true);
 }
 
+void Test::fingerprintIndex() {
+  Log::get().info("Testing fingerprint index");
+  FingerprintIndex index;
+  std::map<uint64_t, std::vector<uint32_t>> expected;
+  // use few fingerprints to get many IDs per fingerprint
+  for (size_t id = 1; id <= 5000; id++) {
+    const uint64_t fp =
+        FingerprintIndex::fingerprint(Sequence({(int64_t)(id % 1500)}));
+    index.insert(fp, id);
+    expected[fp].push_back(id);
+    if (id % 3 == 0) {
+      // remove an earlier ID
+      const uint64_t fp2 =
+          FingerprintIndex::fingerprint(Sequence({(int64_t)((id / 2) % 1500)}));
+      auto& v = expected[fp2];
+      if (!v.empty()) {
+        index.remove(fp2, v.front());
+        v.erase(v.begin());
+      }
+    }
+  }
+  size_t num_ids = 0;
+  for (const auto& e : expected) {
+    auto range = index.find(e.first);
+    std::vector<uint32_t> got(range.first, range.second);
+    if (got != e.second) {
+      Log::get().error("Unexpected IDs in fingerprint index", true);
+    }
+    num_ids += e.second.size();
+  }
+  if (index.size() != expected.size() || index.numIds() != num_ids) {
+    Log::get().error("Unexpected size of fingerprint index", true);
+  }
+  auto range = index.find(FingerprintIndex::fingerprint(Sequence({-1})));
+  if (range.first != range.second) {
+    Log::get().error("Unexpected match in fingerprint index", true);
+  }
+
+  // write and map the index of a matcher
+  LinearMatcher matcher(false), mapped(false);
+  for (int64_t id = 1; id <= 100; id++) {
+    Sequence s;
+    for (int64_t n = 0; n < 10; n++) {
+      s.push_back(Number(id * n * n + (id % 7) * n + id));
+    }
+    matcher.insert(s, id);
+  }
+  const std::string path = getTmpDir() + "loda_test_matcher.bin";
+  {
+    std::ofstream out(path, std::ios::binary);
+    matcher.writeIndex(out);
+  }
+  auto file = std::make_shared<MappedFile>(path);
+  file->refresh();
+  size_t pos = 0;
+  mapped.mapIndex(file, pos);
+  if (pos != file->size() ||
+      mapped.getCompationRatio() != matcher.getCompationRatio()) {
+    Log::get().error("Unexpected mapped matcher index", true);
+  }
+  Sequence query;
+  for (int64_t n = 0; n < 10; n++) {
+    query.push_back(Number(3 * n * n + 3 * n + 3));
+  }
+  for (bool removed : {false, true}) {
+    Matcher::seq_programs_t expected, got;
+    matcher.match(Program(), query, expected);
+    mapped.match(Program(), query, got);
+    if (got != expected || expected.empty() != removed) {
+      Log::get().error("Unexpected match using mapped matcher index", true);
+    }
+    for (const auto& m : expected) {
+      matcher.remove(query, m.first);
+      mapped.remove(query, m.first);
+    }
+  }
+
+  // reject an index with a slot that points beyond its IDs
+  {
+    std::ofstream out(path, std::ios::binary);
+    index.write(out);
+  }
+  std::string data;
+  {
+    std::ifstream in(path, std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(in),
+                std::istreambuf_iterator<char>());
+  }
+  const size_t slots_pos = 4 * sizeof(uint64_t);
+  for (size_t i = slots_pos; i + 16 <= data.size(); i += 16) {
+    uint32_t start, count = 0xffff;
+    std::memcpy(&start, data.data() + i + 8, sizeof(start));
+    if (start != 0xffffffff) {  // non-empty slot
+      std::memcpy(&data[i + 12], &count, sizeof(count));
+      break;
+    }
+  }
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), data.size());
+  }
+  file = std::make_shared<MappedFile>(path);
+  file->refresh();
+  pos = 0;
+  FingerprintIndex corrupted;
+  bool rejected = false;
+  try {
+    corrupted.map(file, pos);
+  } catch (const std::exception&) {
+    rejected = true;
+  }
+  if (!rejected) {
+    Log::get().error("Expected error for invalid fingerprint index slot", true);
+  }
+  std::filesystem::remove(path);
+}
+
+void Test::bloomFilter() {
+  Log::get().info("Testing bloom filter");
+  for (double rate : {0.1, 0.01, 0.001}) {
+    BloomFilter filter;
+    filter.init(10000, rate);
+    for (uint64_t i = 0; i < 10000; i++) {
+      filter.insert(FingerprintIndex::combine(0, i));
+    }
+    for (uint64_t i = 0; i < 10000; i++) {
+      if (!filter.contains(FingerprintIndex::combine(0, i))) {
+        Log::get().error("Missing fingerprint in bloom filter", true);
+      }
+    }
+    size_t num_false_positives = 0;
+    const size_t num_lookups = 100000;
+    for (uint64_t i = 0; i < num_lookups; i++) {
+      num_false_positives +=
+          filter.contains(FingerprintIndex::combine(0, 10000 + i));
+    }
+    if (num_false_positives > 2 * rate * num_lookups) {
+      Log::get().error("Unexpected false positive rate of bloom filter: " +
+                           std::to_string(num_false_positives / 1000.0) + "%",
+                       true);
+    }
+  }
+  // fingerprints are forgotten after two generations
+  AgingBloomFilter aging(1000, 0.01, std::chrono::seconds(3600));
+  for (uint64_t i = 0; i < 3000; i++) {
+    aging.insert(FingerprintIndex::combine(0, i));
+    if (!aging.contains(FingerprintIndex::combine(0, i))) {
+      Log::get().error("Missing fingerprint in aging bloom filter", true);
+    }
+  }
+  size_t num_old = 0, num_recent = 0;
+  for (uint64_t i = 0; i < 1000; i++) {
+    num_old += aging.contains(FingerprintIndex::combine(0, i));
+    num_recent += aging.contains(FingerprintIndex::combine(0, 1000 + i));
+  }
+  if (num_old > 50 || num_recent != 1000) {
+    Log::get().error("Unexpected decay of aging bloom filter", true);
+  }
+}
+
+void Test::fusedReduction() {
+  Log::get().info("Testing fused reductions");
+  std::vector<Sequence> seqs = {
+      Sequence(), Sequence({0, 0, 0}), Sequence({5}), Sequence({-3, 6, 9}),
+      Sequence({4, 8, 6, 10}), Sequence({7, 7, 12, 17}),
+      Sequence({-1, 0, 1, -1}), Sequence({10, 20, 35, 99, 1000})};
+  // terms of test programs
+  Parser parser;
+  Evaluator evaluator(settings);
+  const std::string dir = std::string("tests") + FILE_SEP + "programs" +
+                          FILE_SEP + "oeis" + FILE_SEP + "000" + FILE_SEP;
+  for (const auto& f : std::filesystem::directory_iterator(dir)) {
+    if (f.path().extension() == ".asm") {
+      Sequence s;
+      evaluator.eval(parser.parse(f.path().string()), s, 20, false);
+      seqs.push_back(s);
+    }
+  }
+  ReductionContext ctx;
+  ctx.addDigitBase(2);
+  ctx.addDigitBase(10);
+  for (const auto& seq : seqs) {
+    ctx.init(seq);
+    Sequence expected, got;
+    expected = seq;
+    line_t l1;
+    l1.offset = Reducer::truncate(expected);
+    l1.factor = Reducer::shrink(expected);
+    auto l2 = Reducer::linear1(seq, ctx, got);
+    if (got != expected || l1.offset != l2.offset || l1.factor != l2.factor) {
+      Log::get().error("Unexpected linear1 reduction of " + seq.to_string(),
+                       true);
+    }
+    expected = seq;
+    l1.factor = Reducer::shrink(expected);
+    l1.offset = Reducer::truncate(expected);
+    l2 = Reducer::linear2(seq, ctx, got);
+    if (got != expected || l1.offset != l2.offset || l1.factor != l2.factor) {
+      Log::get().error("Unexpected linear2 reduction of " + seq.to_string(),
+                       true);
+    }
+    for (int64_t base : {2, 10}) {
+      expected = seq;
+      auto d1 = Reducer::digit(expected, base);
+      auto d2 = Reducer::digit(seq, ctx, base, got);
+      if (got != expected || d1 != d2) {
+        Log::get().error("Unexpected digit reduction of " + seq.to_string(),
+                         true);
+      }
+    }
+  }
+}
+
+void Test::parallelFinder() {
+  Log::get().info("Testing parallel finder");
+  Settings s = settings;
+  s.miner_profile = "update";  // matchers without random back off
+  s.max_cycles = 100000;
+  Evaluator evaluator(s);
+  Parser parser;
+  std::vector<Program> programs;
+  std::vector<OeisSequence> sequences(1);  // IDs start at 1
+  const std::string dir = std::string("tests") + FILE_SEP + "programs" +
+                          FILE_SEP + "oeis" + FILE_SEP + "000" + FILE_SEP;
+  for (const auto& f : std::filesystem::directory_iterator(dir)) {
+    if (f.path().extension() == ".asm") {
+      Sequence terms;
+      auto p = parser.parse(f.path().string());
+      evaluator.eval(p, terms, 40, false);
+      if (terms.size() == 40) {
+        programs.push_back(p);
+        sequences.emplace_back(sequences.size(), "", terms);
+      }
+    }
+  }
+  // search for the (modified) programs using one and multiple threads, and
+  // with the prefix filters of the matchers that support them (the delta
+  // matcher does not)
+  Matcher::seq_programs_t results[4];
+  for (size_t i = 0; i < 4; i++) {
+    s.num_find_threads = (i % 2 == 0) ? 1 : 3;
+    Finder finder(s, evaluator);
+    for (size_t id = 1; id < sequences.size(); id++) {
+      finder.insert(sequences[id].getTerms(s.num_terms), id);
+    }
+    if (i >= 2) {
+      finder.initPrefixIndex(sequences.size());
+      for (size_t id = 1; id < sequences.size(); id++) {
+        finder.insertPrefix(sequences[id].getTerms(s.num_terms));
+      }
+    }
+    Sequence norm_seq;
+    for (auto p : programs) {
+      for (int64_t c = 0; c < 3; c++) {
+        auto r = finder.findSequence(p, norm_seq, sequences);
+        results[i].insert(results[i].end(), r.begin(), r.end());
+        // either fully evaluated or cleared
+        if (!norm_seq.empty() && norm_seq.size() != s.num_terms) {
+          Log::get().error("Unexpected normalized sequence", true);
+        }
+        p.push_back(Operation::Type::ADD, Operand::Type::DIRECT,
+                    Program::OUTPUT_CELL, Operand::Type::CONSTANT, c + 1);
+      }
+    }
+  }
+  if (results[0].empty() || results[0] != results[1] ||
+      results[0] != results[2] || results[0] != results[3]) {
+    Log::get().error("Unexpected results of parallel finder", true);
+  }
+}
+
+void Test::outputCache() {
+  Log::get().info("Testing output cache");
+  Settings s = settings;
+  s.miner_profile = "update";
+  s.use_output_cache = true;
+  Evaluator evaluator(s);
+  Parser parser;
+  auto p = parser.parse(ProgramUtil::getProgramPath(45));
+  std::vector<OeisSequence> sequences(1);
+  Sequence norm_seq;
+  const std::string path = getTmpDir() + "loda_test_outputs.bin";
+  std::filesystem::remove(path);
+  // the caches of different matchers are not shared
+  {
+    Settings s2 = s;
+    s2.miner_profile = "default";
+    Finder f1(s, evaluator), f2(s2, evaluator), f3(s, evaluator);
+    if (f1.getMatchersKey() == f2.getMatchersKey() ||
+        f1.getMatchersKey() != f3.getMatchersKey()) {
+      Log::get().error("Unexpected matchers key", true);
+    }
+  }
+  // matchers report the back off, so that its outputs are not cached
+  {
+    DirectMatcher matcher(true);
+    Sequence seq({1, 2, 3, 5, 8, 13, 21, 34});
+    ReductionContext ctx;
+    Matcher::matches_t matches;
+    bool backed_off = false;
+    for (size_t i = 0; i < 1000 && !backed_off; i++) {
+      ctx.init(seq);
+      backed_off = !matcher.match(seq, ctx, matches);
+    }
+    if (!backed_off || !DirectMatcher(false).match(seq, ctx, matches)) {
+      Log::get().error("Unexpected back off of matcher", true);
+    }
+  }
+  size_t num_duplicates = 0;  // identical outputs of one program
+  for (uint64_t key : {1, 1, 2}) {
+    const bool saved = std::filesystem::exists(path);
+    Finder finder(s, evaluator);
+    finder.loadOutputCache(path, key);
+    finder.findSequence(p, norm_seq, sequences);
+    auto stats = finder.getOutputCacheStats(true);
+    if (!saved) {
+      num_duplicates = stats.second;
+    }
+    // the outputs are known if the cache was saved using the same key
+    const size_t expected_hits =
+        (saved && key == 1) ? stats.first : num_duplicates;
+    if (stats.first == 0 || stats.second != expected_hits) {
+      Log::get().error("Unexpected output cache hits after loading", true);
+    }
+    finder.findSequence(p, norm_seq, sequences);
+    stats = finder.getOutputCacheStats(true);
+    if (stats.first == 0 || stats.second != stats.first) {
+      Log::get().error("Unexpected output cache hits", true);
+    }
+    finder.saveOutputCache();
+  }
+  std::filesystem::remove(path);
+
+  // outputs with possible matches are not cached
+  Sequence terms;
+  evaluator.eval(p, terms, s.num_terms, false);
+  sequences.emplace_back(1, "", terms);
+  Finder finder(s, evaluator);
+  finder.insert(sequences[1].getTerms(s.num_terms), 1);
+  for (size_t i = 0; i < 2; i++) {
+    if (finder.findSequence(p, norm_seq, sequences).empty()) {
+      Log::get().error("Expected match after output cache lookup", true);
+    }
+  }
+}
+
 void Test::linearMatcher() {
   LinearMatcher matcher(false);
   testMatcherSet(matcher, {27, 5843, 8585, 16789});
@@ -1348,6 +2452,28 @@ void Test::digitMatcher() {
   // testMatcherPair( decimal, 11557, 7 );
 }
 
+void Test::shiftMatcher() {
+  ShiftMatcher matcher;
+  testMatcherPair(matcher, 1477, 27);
+  testMatcherPair(matcher, 32, 204);
+  // negative shifts are not matched, because the candidates lack first terms
+  Parser parser;
+  Evaluator evaluator(settings);
+  for (auto ids : std::vector<std::pair<size_t, size_t>>{{27, 1477},
+                                                         {204, 32}}) {
+    Sequence s1, s2;
+    evaluator.eval(parser.parse(ProgramUtil::getProgramPath(ids.first)), s1);
+    evaluator.eval(parser.parse(ProgramUtil::getProgramPath(ids.second)), s2);
+    matcher.insert(s2, ids.second);
+    Matcher::seq_programs_t result;
+    matcher.match(Program(), s1, result);
+    matcher.remove(s2, ids.second);
+    if (!result.empty() || matcher.verify(s1, s2)) {
+      Log::get().error("shift matcher matched negative shift", true);
+    }
+  }
+}
+
 void Test::testBinary(const std::string& func, const std::string& file,
                       const std::vector<std::vector<int64_t>>& values) {
   Log::get().info("Testing " + file);
@@ -1450,10 +2576,33 @@ void Test::testMatcherPair(Matcher& matcher, size_t id1, size_t id2) {
   Sequence s1, s2, s3;
   eval(p1, evaluator, s1);
   eval(p2, evaluator, s2);
+  // sequences that can be matched have equal prefix keys
+  uint64_t key1, key2;
+  if (matcher.getPrefixKey(s1.subsequence(0, 4), key1) &&
+      matcher.getPrefixKey(s2.subsequence(0, 4), key2) && key1 != key2) {
+    Log::get().error(matcher.getName() + " matcher has unexpected prefix key",
+                     true);
+  }
   matcher.insert(s2, id2);
-  Matcher::seq_programs_t result;
+  Matcher::seq_programs_t result, lazy_result;
   matcher.match(p1, s1, result);
+  // the verified and extended lazy matches are the same as the full matches
+  ReductionContext ctx;
+  matcher.configure(ctx);
+  ctx.init(s1);
+  Matcher::matches_t matches;
+  matcher.match(s1, ctx, matches);
+  for (const auto& m : matches) {
+    Program p = p1;
+    if (m.id == id2 && matcher.verify(s1, s2) && matcher.extendProgram(p, m)) {
+      lazy_result.push_back({m.id, p});
+    }
+  }
   matcher.remove(s2, id2);
+  if (lazy_result != result) {
+    Log::get().error(matcher.getName() + " matcher has unexpected lazy matches",
+                     true);
+  }
   if (result.size() != 1) {
     Log::get().error(matcher.getName() + " matcher unable to match sequence",
                      true);
@@ -48,6 +48,32 @@ class Test {
 
   void checkpoint();
 
+  void termStore();
+
+  void programStore();
+
+  void seqTerms();
+
+  void recursion();
+
+  void updatedCallee();
+
+  void incEvalSeq();
+
+  void matrixEval();
+
+  void evalCheckpoint();
+
+  void threadedEval();
+
+  void prefixCache();
+
+  void probeCheck();
+
+  void stepEstimate();
+
+  void trivialPrograms();
+
   void oeisList();
 
   void oeisSeq();
@@ -64,12 +90,24 @@ class Test {
 
   void miner();
 
+  void fingerprintIndex();
+
+  void bloomFilter();
+
+  void fusedReduction();
+
+  void parallelFinder();
+
+  void outputCache();
+
   void linearMatcher();
 
   void deltaMatcher();
 
   void digitMatcher();
 
+  void shiftMatcher();
+
   void stats();
 
   void config();
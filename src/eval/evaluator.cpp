@@ -1,10 +1,37 @@
 #include "eval/evaluator.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
 
 #include "lang/program_util.hpp"
 #include "sys/log.hpp"
 
+// format tag and write interval of checkpoint files
+static const std::string CHECKPOINT_TAG = "loda-checkpoint-v1";
+static constexpr int64_t CHECKPOINT_INTERVAL_SECS = 10;
+
+// minimum number of terms for evaluation using multiple threads
+static constexpr int64_t MIN_THREADED_TERMS = 256;
+
+// minimum number of operations of a shared prefix to cache its states
+static constexpr size_t MIN_PREFIX_LENGTH = 2;
+
+// number of terms evaluated before probing later terms in checks, and maximum
+// cost of the probes relative to the cost of these terms
+static constexpr int64_t PROBE_PREFIX_LENGTH = 8;
+static constexpr double PROBE_COST_FACTOR = 4.0;
+
+// minimum index of terms evaluated using matrix exponentiation, which is
+// faster only for many loop iterations and if the terms are not big numbers
+static constexpr int64_t MIN_MATRIX_INDEX = 100;
+
+static bool useMatrixTerm(int64_t i, const Sequence &seq) {
+  return i >= MIN_MATRIX_INDEX && seq[i - 1].getNumUsedWords() == 1;
+}
+
 steps_t::steps_t() : min(0), max(0), total(0), runs(0) {}
 
 void steps_t::add(size_t s) {
@@ -25,9 +52,18 @@ Evaluator::Evaluator(const Settings &settings, const bool use_inc_eval)
     : settings(settings),
       interpreter(settings),
       inc_evaluator(interpreter),
+      mat_evaluator(interpreter),
       use_inc_eval(use_inc_eval),
       check_eval_time(settings.max_eval_secs >= 0),
-      is_debug(Log::get().level == Log::Level::DEBUG) {}
+      is_debug(Log::get().level == Log::Level::DEBUG),
+      last_use_inc(false),
+      last_prefix_length(0),
+      checkpoint_num_evaluated(0) {
+  if (settings.num_eval_threads > 1) {
+    thr_evaluator.reset(
+        new ThreadedEvaluator(settings, settings.num_eval_threads));
+  }
+}
 
 steps_t Evaluator::eval(const Program &p, Sequence &seq, int64_t num_terms,
                         const bool throw_on_error) {
@@ -42,18 +78,42 @@ steps_t Evaluator::eval(const Program &p, Sequence &seq, int64_t num_terms,
   steps_t steps;
   size_t s;
   const bool use_inc = use_inc_eval && inc_evaluator.init(p);
+  const bool use_mat = useMatrix(p, use_inc);
   std::pair<Number, size_t> inc_result;
   const int64_t offset = ProgramUtil::getOffset(p);
-  for (int64_t i = 0; i < num_terms; i++) {
+
+  // when resuming from a checkpoint, the terms that were evaluated after the
+  // last saved state are evaluated again, but not printed again. b-file lines
+  // are written only together with a checkpoint to avoid duplicates.
+  const bool use_checkpoint = !settings.checkpoint_file.empty();
+  int64_t start = 0, num_printed = 0;
+  std::string b_file_lines;
+  if (use_checkpoint) {
+    start = loadCheckpoint(p, use_inc, num_printed);
+  } else if (!use_inc && !use_mat && !settings.print_as_b_file &&
+             useThreads(num_terms)) {
+    ThreadedEvaluator::Result r;
+    thr_evaluator->eval(p, num_terms, -1, Sequence(), start_time, r);
+    for (size_t i = 0; i < r.num_evaluated; i++) {
+      steps.add(r.steps[i]);
+      seq[i] = settings.use_steps ? Number(r.steps[i]) : r.terms[i];
+    }
+    if (r.error) {
+      seq.resize(r.num_evaluated);
+      if (throw_on_error) {
+        std::rethrow_exception(r.error);
+      }
+    }
+    return steps;
+  }
+  for (int64_t i = start; i < num_terms; i++) {
     try {
       if (use_inc) {
         inc_result = inc_evaluator.next();
         seq[i] = inc_result.first;
         s = inc_result.second;
       } else {
-        mem.clear();
-        mem.set(Program::INPUT_CELL, i + offset);
-        s = interpreter.run(p, mem);
+        s = runTerm(p, mem, i + offset, use_mat && useMatrixTerm(i, seq));
         seq[i] = mem.get(Program::OUTPUT_CELL);
       }
       if (check_eval_time) {
@@ -61,6 +121,10 @@ steps_t Evaluator::eval(const Program &p, Sequence &seq, int64_t num_terms,
       }
     } catch (const std::exception &) {
       seq.resize(i);
+      if (use_checkpoint) {
+        std::cout << b_file_lines << std::flush;
+        saveCheckpoint(p, use_inc, -1, std::max(i, num_printed));
+      }
       if (throw_on_error) {
         throw;
       } else {
@@ -73,9 +137,27 @@ steps_t Evaluator::eval(const Program &p, Sequence &seq, int64_t num_terms,
       seq[i] = s;
     }
     if (settings.print_as_b_file) {
-      std::cout << (offset + i) << " " << seq[i] << std::endl;
+      if (!use_checkpoint) {
+        std::cout << (offset + i) << " " << seq[i] << std::endl;
+      } else if (i >= num_printed) {
+        b_file_lines += std::to_string(offset + i) + " " + seq[i].to_string() +
+                        "\n";
+      }
+    }
+    if (use_checkpoint &&
+        std::chrono::steady_clock::now() >= checkpoint_time +
+                                                std::chrono::seconds(
+                                                    CHECKPOINT_INTERVAL_SECS)) {
+      std::cout << b_file_lines << std::flush;
+      b_file_lines.clear();
+      saveCheckpoint(p, use_inc, i + 1, std::max(i + 1, num_printed));
     }
   }
+  if (use_checkpoint) {
+    std::cout << b_file_lines << std::flush;
+    saveCheckpoint(p, use_inc, std::max(start, num_terms),
+                   std::max(num_terms, num_printed));
+  }
   if (is_debug) {
     std::stringstream buf;
     buf << "Evaluated program to sequence " << seq;
@@ -85,7 +167,7 @@ steps_t Evaluator::eval(const Program &p, Sequence &seq, int64_t num_terms,
 }
 
 steps_t Evaluator::eval(const Program &p, std::vector<Sequence> &seqs,
-                        int64_t num_terms) {
+                        int64_t num_terms, int64_t start) {
   if (num_terms < 0) {
     num_terms = settings.num_terms;
   }
@@ -97,14 +179,37 @@ steps_t Evaluator::eval(const Program &p, std::vector<Sequence> &seqs,
   }
   Memory mem;
   steps_t steps;
-  // note: we can't use the incremental evaluator here
   const int64_t offset = ProgramUtil::getOffset(p);
-  for (int64_t i = 0; i < num_terms; i++) {
-    mem.clear();
-    mem.set(Program::INPUT_CELL, i + offset);
-    steps.add(interpreter.run(p, mem));
+  if (start == 0) {
+    last_use_inc = use_inc_eval && inc_evaluator.init(p) &&
+                   inc_evaluator.isLastStateComplete();
+    last_prefix_length = last_use_inc ? 0 : preparePrefix(p, offset);
+  }
+  // the incremental evaluator and the prefix cache keep their state
+  const bool use_inc = last_use_inc;
+  const size_t prefix_length = last_prefix_length;
+  for (int64_t i = start; i < num_terms; i++) {
+    if (use_inc) {
+      steps.add(inc_evaluator.next().second);
+    } else if (prefix_length > 0) {
+      // terms are evaluated in order, so we extend the cache if needed
+      if (static_cast<size_t>(i) == prefix_cache.states.size()) {
+        mem.clear();
+        mem.set(Program::INPUT_CELL, i + offset);
+        prefix_cache.steps.push_back(interpreter.run(prefix_cache.prefix, mem));
+        prefix_cache.states.push_back(mem);
+      }
+      mem = prefix_cache.states[i];
+      steps.add(
+          interpreter.resume(p, mem, prefix_length, prefix_cache.steps[i]));
+    } else {
+      mem.clear();
+      mem.set(Program::INPUT_CELL, i + offset);
+      steps.add(interpreter.run(p, mem));
+    }
+    const auto &state = use_inc ? inc_evaluator.getLastState() : mem;
     for (size_t s = 0; s < seqs.size(); s++) {
-      seqs[s][i] = mem.get(s);
+      seqs[s][i] = state.get(s);
     }
     if (check_eval_time) {
       checkEvalTime();
@@ -125,22 +230,67 @@ std::pair<status_t, steps_t> Evaluator::check(const Program &p,
   }
   std::pair<status_t, steps_t> result;
   Memory mem;
-  // clear cache to correctly detect recursion errors
-  interpreter.clearCaches();
+  // invalidate cached terms that depend on the checked program to correctly
+  // detect recursion errors
+  interpreter.invalidateCaches(id);
+  clearPrefix();
   const bool use_inc = use_inc_eval && inc_evaluator.init(p);
+  const bool use_mat = useMatrix(p, use_inc);
+  if (!use_inc && !use_mat && !settings.print_as_b_file &&
+      useThreads(expected_seq.size())) {
+    thr_evaluator->invalidateCaches(id);
+    ThreadedEvaluator::Result r;
+    thr_evaluator->eval(p, expected_seq.size(), id, expected_seq, start_time,
+                        r);
+    for (size_t i = 0; i < r.num_evaluated; i++) {
+      result.second.add(r.steps[i]);
+    }
+    // steps of a mismatching or timed out term are counted as in sequential
+    // evaluation
+    if (r.has_failed_steps) {
+      result.second.add(r.steps[r.num_evaluated]);
+    }
+    if (r.num_evaluated == expected_seq.size()) {
+      result.first = status_t::OK;
+    } else if (r.error) {
+      result.first = ((int64_t)r.num_evaluated >= num_required_terms)
+                         ? status_t::WARNING
+                         : status_t::ERROR;
+    } else {
+      result.first = status_t::ERROR;
+    }
+    return result;
+  }
   std::pair<Number, size_t> inc_result;
   Number out;
   const int64_t offset = ProgramUtil::getOffset(p);
+  const bool use_probes = !use_inc && !settings.print_as_b_file &&
+                          num_required_terms > 2 * PROBE_PREFIX_LENGTH;
+  std::vector<size_t> prefix_steps;
+  std::unordered_map<size_t, size_t> probed_steps;
   for (size_t i = 0; i < expected_seq.size(); i++) {
+    if (use_probes && i == PROBE_PREFIX_LENGTH &&
+        !probeTerms(p, expected_seq, num_required_terms, id, use_mat,
+                    prefix_steps, probed_steps)) {
+      result.first = status_t::ERROR;
+      return result;
+    }
     try {
       if (use_inc) {
         inc_result = inc_evaluator.next();
         out = inc_result.first;
+      } else if (probed_steps.count(i)) {
+        result.second.add(probed_steps[i]);
+        out = expected_seq[i];
       } else {
-        mem.clear();
-        mem.set(Program::INPUT_CELL, i + offset);
-        result.second.add(interpreter.run(p, mem, id));
+        const size_t s =
+            runTerm(p, mem, i + offset,
+                    use_mat && useMatrixTerm(i, expected_seq), id);
+        result.second.add(s);
         out = mem.get(Program::OUTPUT_CELL);
+        if (use_probes && i < PROBE_PREFIX_LENGTH) {
+          prefix_steps.push_back(s);
+        }
       }
       if (check_eval_time) {
         checkEvalTime();
@@ -169,13 +319,152 @@ std::pair<status_t, steps_t> Evaluator::check(const Program &p,
   return result;
 }
 
+bool Evaluator::probeTerms(const Program &p, const Sequence &expected_seq,
+                           int64_t num_required_terms, int64_t id,
+                           bool use_mat,
+                           const std::vector<size_t> &prefix_steps,
+                           std::unordered_map<size_t, size_t> &probed_steps) {
+  // estimate the steps of later terms using a power law fitted to the steps
+  // of the first terms: log(steps) = a + b * log(index + 1)
+  const double n = prefix_steps.size();
+  double sx = 0, sy = 0, sxx = 0, sxy = 0, budget = 0;
+  for (size_t i = 0; i < prefix_steps.size(); i++) {
+    const double x = std::log(i + 1.0);
+    const double y = std::log(std::max<size_t>(prefix_steps[i], 1));
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+    budget += prefix_steps[i];
+  }
+  const double b = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+  const double a = (sy - b * sx) / n;
+  budget *= PROBE_COST_FACTOR;
+
+  // a failure of a required term results in an error also in a sequential
+  // check, so we probe only required terms. cheap probes come first.
+  const int64_t max_index =
+      std::min<int64_t>(num_required_terms, expected_seq.size()) - 1;
+  std::vector<std::pair<double, int64_t>> probes;
+  for (int64_t i = 2 * PROBE_PREFIX_LENGTH - 1; i <= max_index; i = 2 * i + 1) {
+    probes.push_back({std::exp(a + b * std::log(i + 1.0)), i});
+  }
+  probes.push_back({std::exp(a + b * std::log(max_index + 1.0)), max_index});
+  std::sort(probes.begin(), probes.end());
+
+  Memory mem;
+  const int64_t offset = ProgramUtil::getOffset(p);
+  const auto probe_start = std::chrono::steady_clock::now();
+  double spent = 0;
+  for (const auto &probe : probes) {
+    if (spent + probe.first > budget) {
+      break;
+    }
+    const int64_t i = probe.second;
+    if (probed_steps.count(i)) {
+      continue;
+    }
+    size_t s;
+    try {
+      s = runTerm(p, mem, i + offset,
+                  use_mat && useMatrixTerm(i, expected_seq), id);
+    } catch (const std::exception &) {
+      return false;
+    }
+    if (check_eval_time) {
+      try {
+        checkEvalTime();
+      } catch (const std::exception &) {
+        // a timeout is not an error of the probed term, so we continue with
+        // the normal evaluation using the full evaluation time
+        probed_steps.clear();
+        start_time += std::chrono::steady_clock::now() - probe_start;
+        return true;
+      }
+    }
+    if (mem.get(Program::OUTPUT_CELL) != expected_seq[i]) {
+      return false;
+    }
+    probed_steps[i] = s;
+    spent += s;
+  }
+  return true;
+}
+
 bool Evaluator::supportsIncEval(const Program &p) {
   bool result = inc_evaluator.init(p);
   inc_evaluator.reset();
   return result;
 }
 
-void Evaluator::clearCaches() { interpreter.clearCaches(); }
+void Evaluator::clearCaches() {
+  interpreter.clearCaches();
+  clearPrefix();
+  if (thr_evaluator) {
+    thr_evaluator->clearCaches();
+  }
+}
+
+size_t Evaluator::preparePrefix(const Program &p, int64_t offset) {
+  size_t length = 0;
+  while (length < p.ops.size() && p.ops[length].type != Operation::Type::LPB) {
+    length++;
+  }
+  // reuse the cached states if the program starts with the cached prefix
+  const auto &cached = prefix_cache.prefix.ops;
+  if (!cached.empty() && cached.size() <= length &&
+      prefix_cache.offset == offset &&
+      std::equal(cached.begin(), cached.end(), p.ops.begin())) {
+    last_prefix.assign(p.ops.begin(), p.ops.begin() + length);
+    return cached.size();
+  }
+  // otherwise cache the prefix shared with the last evaluated program
+  size_t shared = 0;
+  while (shared < length && shared < last_prefix.size() &&
+         p.ops[shared] == last_prefix[shared]) {
+    shared++;
+  }
+  last_prefix.assign(p.ops.begin(), p.ops.begin() + length);
+  clearPrefix();
+  if (shared < MIN_PREFIX_LENGTH) {
+    return 0;
+  }
+  prefix_cache.prefix.ops.assign(p.ops.begin(), p.ops.begin() + shared);
+  prefix_cache.offset = offset;
+  return shared;
+}
+
+void Evaluator::clearPrefix() {
+  prefix_cache.prefix.ops.clear();
+  prefix_cache.states.clear();
+  prefix_cache.steps.clear();
+}
+
+bool Evaluator::useThreads(int64_t num_terms) const {
+  return thr_evaluator && num_terms >= MIN_THREADED_TERMS;
+}
+
+bool Evaluator::useMatrix(const Program &p, bool use_inc) {
+  // called programs are excluded, because the matrix evaluator does not
+  // detect recursive calls of the checked program
+  return !use_inc && !ProgramUtil::hasOp(p, Operation::Type::SEQ) &&
+         !ProgramUtil::hasOp(p, Operation::Type::PRG) &&
+         mat_evaluator.init(p);
+}
+
+size_t Evaluator::runTerm(const Program &p, Memory &mem, int64_t index,
+                          bool use_mat, int64_t id) {
+  mem.clear();
+  mem.set(Program::INPUT_CELL, index);
+  if (use_mat) {
+    std::pair<Number, size_t> result;
+    if (mat_evaluator.eval(index, result)) {
+      mem.set(Program::OUTPUT_CELL, result.first);
+      return result.second;
+    }
+  }
+  return interpreter.run(p, mem, id);
+}
 
 void Evaluator::checkEvalTime() const {
   const int64_t millis = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -185,3 +474,70 @@ void Evaluator::checkEvalTime() const {
     throw std::runtime_error("maximum evaluation time exceeded");
   }
 }
+
+int64_t Evaluator::loadCheckpoint(const Program &p, bool use_inc,
+                                  int64_t &num_printed) {
+  checkpoint_time = std::chrono::steady_clock::now();
+  checkpoint_num_evaluated = 0;
+  num_printed = 0;
+  checkpoint_inc_state.clear();
+  std::ifstream in(settings.checkpoint_file);
+  if (!in.good()) {
+    // start a new evaluation
+    if (use_inc) {
+      std::stringstream buf;
+      inc_evaluator.saveState(buf);
+      checkpoint_inc_state = buf.str();
+    }
+    return 0;
+  }
+  std::string line, tag;
+  size_t hash = 0;
+  bool use_steps = false, has_inc_state = false;
+  std::getline(in, line);
+  std::stringstream header(line);
+  header >> tag >> hash >> use_steps >> has_inc_state >> num_printed >>
+      checkpoint_num_evaluated;
+  if (!header || tag != CHECKPOINT_TAG || hash != ProgramUtil::hash(p) ||
+      use_steps != settings.use_steps || has_inc_state != use_inc ||
+      checkpoint_num_evaluated > num_printed) {
+    throw std::runtime_error("Checkpoint does not match program: " +
+                             settings.checkpoint_file);
+  }
+  if (use_inc) {
+    std::stringstream buf;
+    buf << in.rdbuf();
+    checkpoint_inc_state = buf.str();
+    std::stringstream state(checkpoint_inc_state);
+    inc_evaluator.loadState(state);
+  }
+  Log::get().info("Resuming evaluation from checkpoint at term " +
+                  std::to_string(checkpoint_num_evaluated));
+  return checkpoint_num_evaluated;
+}
+
+void Evaluator::saveCheckpoint(const Program &p, bool use_inc,
+                               int64_t num_evaluated, int64_t num_printed) {
+  if (!use_inc) {
+    checkpoint_num_evaluated = num_printed;
+  } else if (num_evaluated >= 0) {
+    std::stringstream buf;
+    inc_evaluator.saveState(buf);
+    checkpoint_inc_state = buf.str();
+    checkpoint_num_evaluated = num_evaluated;
+  }
+  // write to a temporary file first to not lose the old checkpoint
+  const std::string tmp = settings.checkpoint_file + ".tmp";
+  {
+    std::ofstream out(tmp);
+    out << CHECKPOINT_TAG << " " << ProgramUtil::hash(p) << " "
+        << settings.use_steps << " " << use_inc << " " << num_printed << " "
+        << checkpoint_num_evaluated << std::endl
+        << checkpoint_inc_state;
+    if (!out.good()) {
+      throw std::runtime_error("Cannot write checkpoint: " + tmp);
+    }
+  }
+  std::filesystem::rename(tmp, settings.checkpoint_file);
+  checkpoint_time = std::chrono::steady_clock::now();
+}
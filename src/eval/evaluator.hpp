@@ -1,8 +1,12 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
+#include <unordered_map>
 
 #include "eval/evaluator_inc.hpp"
+#include "eval/evaluator_mat.hpp"
+#include "eval/evaluator_thr.hpp"
 #include "eval/interpreter.hpp"
 #include "math/sequence.hpp"
 
@@ -26,8 +30,11 @@ class Evaluator {
   steps_t eval(const Program &p, Sequence &seq, int64_t num_terms = -1,
                const bool throw_on_error = true);
 
+  // Evaluate the terms of all memory cells. If start is positive, the
+  // evaluation of the same program in the previous call is continued, i.e.,
+  // only the terms from start on are evaluated.
   steps_t eval(const Program &p, std::vector<Sequence> &seqs,
-               int64_t num_terms = -1);
+               int64_t num_terms = -1, int64_t start = 0);
 
   std::pair<status_t, steps_t> check(const Program &p,
                                      const Sequence &expected_seq,
@@ -40,14 +47,73 @@ class Evaluator {
 
   void clearCaches();
 
+  void setSeqTermsProvider(SeqTermsProvider *provider) {
+    interpreter.setSeqTermsProvider(provider);
+  }
+
  private:
   const Settings &settings;
   Interpreter interpreter;
   IncrementalEvaluator inc_evaluator;
+  MatrixEvaluator mat_evaluator;
+  std::unique_ptr<ThreadedEvaluator> thr_evaluator;
   const bool use_inc_eval;
   const bool check_eval_time;
   const bool is_debug;
   std::chrono::time_point<std::chrono::steady_clock> start_time;
 
+  // memory states and steps of the terms after a loop-free prefix that is
+  // shared by the last evaluated programs, e.g., mutants of the same program
+  struct PrefixCache {
+    Program prefix;
+    int64_t offset = 0;
+    std::vector<Memory> states;
+    std::vector<size_t> steps;
+  };
+  PrefixCache prefix_cache;
+  std::vector<Operation> last_prefix;
+
+  // evaluation mode of the last program evaluated for all memory cells
+  bool last_use_inc;
+  size_t last_prefix_length;
+
+  // checkpoint of the last b-file generation
+  std::chrono::time_point<std::chrono::steady_clock> checkpoint_time;
+  std::string checkpoint_inc_state;
+  int64_t checkpoint_num_evaluated;
+
   void checkEvalTime() const;
+
+  bool useThreads(int64_t num_terms) const;
+
+  // Matrix evaluation is used for programs that are not evaluated
+  // incrementally, e.g. for random access to terms.
+  bool useMatrix(const Program &p, bool use_inc);
+
+  // Evaluate a single term using the matrix evaluator if possible, or using
+  // the interpreter otherwise. The result is stored in the output cell.
+  size_t runTerm(const Program &p, Memory &mem, int64_t index, bool use_mat,
+                 int64_t id = -1);
+
+  // Returns the length of the cached prefix to resume the evaluation of the
+  // program from, or 0 if no prefix should be used.
+  size_t preparePrefix(const Program &p, int64_t offset);
+
+  void clearPrefix();
+
+  // Evaluate a sample of later required terms to reject wrong programs early.
+  // Returns false if a term is wrong or cannot be evaluated. Correct terms are
+  // stored with their steps for reuse. If the evaluation time is exceeded, the
+  // probes are discarded and the time spent on them is not counted.
+  bool probeTerms(const Program &p, const Sequence &expected_seq,
+                  int64_t num_required_terms, int64_t id, bool use_mat,
+                  const std::vector<size_t> &prefix_steps,
+                  std::unordered_map<size_t, size_t> &probed_steps);
+
+  int64_t loadCheckpoint(const Program &p, bool use_inc,
+                         int64_t &num_printed);
+
+  // use num_evaluated = -1 to keep the previously saved IE state
+  void saveCheckpoint(const Program &p, bool use_inc, int64_t num_evaluated,
+                      int64_t num_printed);
 };
@@ -1,5 +1,7 @@
 #include "eval/evaluator_inc.hpp"
 
+#include <sstream>
+
 #include "eval/semantics.hpp"
 #include "lang/program_util.hpp"
 #include "sys/log.hpp"
@@ -39,7 +41,46 @@ void IncrementalEvaluator::reset() {
 bool IncrementalEvaluator::init(const Program& program,
                                 bool skip_input_transform, bool skip_offset) {
   reset();
-  simple_loop = Analyzer::extractSimpleLoop(program);
+
+  // run the static code analysis or use the cached result
+  const size_t key =
+      ProgramUtil::hash(program) ^ static_cast<size_t>(skip_input_transform);
+  auto it = analysis_cache.find(key);
+  bool is_supported;
+  if (it != analysis_cache.end() && it->second.program == program &&
+      it->second.skip_input_transform == skip_input_transform) {
+    loadAnalysis(it->second);
+    is_supported = it->second.is_supported;
+  } else {
+    is_supported = analyze(program, skip_input_transform);
+    if (analysis_cache.size() >= 1000) {  // magic number
+      analysis_cache.clear();
+    }
+    auto& analysis = analysis_cache[key];
+    analysis.program = program;
+    analysis.skip_input_transform = skip_input_transform;
+    analysis.is_supported = is_supported;
+    saveAnalysis(analysis);
+  }
+  if (!is_supported) {
+    return false;
+  }
+
+  // extract offset from program directive
+  offset = skip_offset ? 0 : ProgramUtil::getOffset(program);
+
+  // initialue the runtime data
+  initRuntimeData();
+  initialized = true;
+  if (is_debug) {
+    Log::get().debug("[IE] Initialization successful");
+  }
+  return true;
+}
+
+bool IncrementalEvaluator::analyze(const Program& program,
+                                   bool skip_input_transform) {
+  simple_loop = Analyzer::extractSimpleLoop(program, true, true);
   if (!simple_loop.is_simple_loop) {
     if (is_debug) {
       Log::get().debug("[IE] Simple loop check failed");
@@ -66,24 +107,56 @@ bool IncrementalEvaluator::init(const Program& program,
     }
     return false;
   }
-  // extract offset from program directive
-  offset = skip_offset ? 0 : ProgramUtil::getOffset(program);
-
-  // initialue the runtime data
-  initRuntimeData();
-  initialized = true;
-  if (is_debug) {
-    Log::get().debug("[IE] Initialization successful");
-  }
   return true;
 }
 
+void IncrementalEvaluator::saveAnalysis(Analysis& analysis) const {
+  analysis.simple_loop = simple_loop;
+  analysis.pre_loop_filtered = pre_loop_filtered;
+  analysis.output_cells = output_cells;
+  analysis.stateful_cells = stateful_cells;
+  analysis.input_dependent_cells = input_dependent_cells;
+  analysis.loop_counter_dependent_cells = loop_counter_dependent_cells;
+  analysis.loop_counter_decrement = loop_counter_decrement;
+  analysis.loop_counter_lower_bound = loop_counter_lower_bound;
+  analysis.loop_counter_type = loop_counter_type;
+}
+
+void IncrementalEvaluator::loadAnalysis(const Analysis& analysis) {
+  simple_loop = analysis.simple_loop;
+  pre_loop_filtered = analysis.pre_loop_filtered;
+  output_cells = analysis.output_cells;
+  stateful_cells = analysis.stateful_cells;
+  input_dependent_cells = analysis.input_dependent_cells;
+  loop_counter_dependent_cells = analysis.loop_counter_dependent_cells;
+  loop_counter_decrement = analysis.loop_counter_decrement;
+  loop_counter_lower_bound = analysis.loop_counter_lower_bound;
+  loop_counter_type = analysis.loop_counter_type;
+}
+
 bool IncrementalEvaluator::isInputDependent(const Operand& op) const {
   return (op.type == Operand::Type::DIRECT &&
           input_dependent_cells.find(op.value.asInt()) !=
               input_dependent_cells.end());
 }
 
+bool IncrementalEvaluator::isLastStateComplete() const {
+  // temporary cells of the loop body are not computed in the same order
+  for (const auto& op : simple_loop.body.ops) {
+    const auto& meta = Operation::Metadata::get(op.type);
+    if (meta.num_operands == 0 || !meta.is_writing_target) {
+      continue;
+    }
+    const auto target = op.target.value.asInt();
+    if (target != simple_loop.counter &&
+        output_cells.find(target) == output_cells.end() &&
+        stateful_cells.find(target) == stateful_cells.end()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool IncrementalEvaluator::checkPreLoop(bool skip_input_transform) {
   // here we do a static code analysis of the pre-loop
   // fragment to make sure here that the loop counter cell
@@ -143,6 +216,7 @@ bool IncrementalEvaluator::checkPreLoop(bool skip_input_transform) {
 bool IncrementalEvaluator::checkLoopBody() {
   // check loop counter cell
   bool loop_counter_updated = false;
+  bool has_lower_bound = false;
   for (const auto& op : simple_loop.body.ops) {
     const auto& meta = Operation::Metadata::get(op.type);
     const auto target = op.target.value.asInt();
@@ -159,6 +233,7 @@ bool IncrementalEvaluator::checkLoopBody() {
                  op.source.type == Operand::Type::CONSTANT) {
         loop_counter_lower_bound = std::max<int64_t>(loop_counter_lower_bound,
                                                      op.source.value.asInt());
+        has_lower_bound = true;
       } else {
         return false;
       }
@@ -173,6 +248,12 @@ bool IncrementalEvaluator::checkLoopBody() {
   if (!loop_counter_updated) {
     return false;
   }
+  // region loops terminate like simple loops only if the counter cell is
+  // strictly decreasing until it becomes negative
+  if (simple_loop.region_length != 1 &&
+      (loop_counter_type != Operation::Type::SUB || has_lower_bound)) {
+    return false;
+  }
   if (loop_counter_decrement < 1 ||
       loop_counter_decrement >
           1000) {  // prevent exhaustive memory usage; magic number
@@ -283,9 +364,16 @@ void IncrementalEvaluator::computeLoopCounterDependentCells() {
 
 bool IncrementalEvaluator::checkPostLoop() {
   // initialize output cells. all memory cells that are read
-  // by the post-loop fragment are output cells.
+  // by the post-loop fragment are output cells. writes inside
+  // of loops are not guaranteed to be executed.
   std::set<int64_t> write;
+  int64_t depth = 0;
   for (const auto& op : simple_loop.post_loop.ops) {
+    if (op.type == Operation::Type::LPB) {
+      depth++;
+    } else if (op.type == Operation::Type::LPE) {
+      depth--;
+    }
     const auto& meta = Operation::Metadata::get(op.type);
     if (meta.num_operands < 1) {
       continue;
@@ -296,7 +384,7 @@ bool IncrementalEvaluator::checkPostLoop() {
         output_cells.insert(target);
       }
     }
-    if (meta.is_writing_target) {
+    if (meta.is_writing_target && depth == 0) {
       write.insert(target);
     }
     if (meta.num_operands < 2) {
@@ -419,3 +507,40 @@ std::pair<Number, size_t> IncrementalEvaluator::next(bool skip_final_iter,
   // return result of execution and steps
   return std::pair<Number, size_t>(tmp_state.get(Program::OUTPUT_CELL), steps);
 }
+
+void IncrementalEvaluator::saveState(std::ostream& out) const {
+  if (!initialized) {
+    throw std::runtime_error("incremental evaluator not initialized");
+  }
+  out << argument << " " << previous_slice << " " << loop_counter_decrement
+      << std::endl;
+  for (int64_t i = 0; i < loop_counter_decrement; i++) {
+    out << previous_loop_counts[i] << " " << total_loop_steps[i] << " "
+        << loop_states[i] << std::endl;
+  }
+}
+
+void IncrementalEvaluator::loadState(std::istream& in) {
+  if (!initialized) {
+    throw std::runtime_error("incremental evaluator not initialized");
+  }
+  std::string line, mem;
+  int64_t decrement = 0;
+  std::getline(in, line);
+  std::stringstream header(line);
+  header >> argument >> previous_slice >> decrement;
+  if (!header || decrement != loop_counter_decrement) {
+    throw std::runtime_error("invalid incremental evaluator state");
+  }
+  for (int64_t i = 0; i < loop_counter_decrement; i++) {
+    std::getline(in, line);
+    std::stringstream buf(line);
+    mem.clear();
+    buf >> previous_loop_counts[i] >> total_loop_steps[i];
+    if (!buf) {
+      throw std::runtime_error("invalid incremental evaluator state");
+    }
+    buf >> mem;  // empty memory is written as empty string
+    loop_states[i] = Memory(mem);
+  }
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <set>
+#include <unordered_map>
 
 #include "eval/interpreter.hpp"
 #include "lang/analyzer.hpp"
@@ -13,11 +14,16 @@
 // only once. This works by remembering the state of the previous iteration and
 // updating it, instead of computing it from scratch. The decision whether IA
 // works for a given program is made using a static code analysis of the program
-// to be executed.
+// to be executed. Besides simple loops, IE supports main loops with a region
+// counter and post-loop fragments that contain further loops, which are
+// evaluated regularly. Chaining several loops that are all evaluated
+// incrementally is not supported, because the counter of a later loop would
+// need to be monotonic in the argument.
 //
 // To find out whether your program is supported by IE, use the init() function.
 // If it returns true, use successive calls to the next() function to compute
-// the next terms.
+// the next terms. The results of the static code analysis are cached, so that
+// repeated initialization using the same program is cheap.
 //
 class IncrementalEvaluator {
  public:
@@ -34,6 +40,12 @@ class IncrementalEvaluator {
   std::pair<Number, size_t> next(bool skip_final_iter = false,
                                  bool skip_post_loop = false);
 
+  // Write the runtime data to a stream, so that the evaluation can be resumed
+  // later. The state can be restored only after initializing the IE using the
+  // same program.
+  void saveState(std::ostream& out) const;
+  void loadState(std::istream& in);
+
   inline const SimpleLoopProgram& getSimpleLoop() const { return simple_loop; }
   inline const Program& getPreLoopFiltered() const { return pre_loop_filtered; }
   inline int64_t getLoopCounterDecrement() const {
@@ -56,9 +68,33 @@ class IncrementalEvaluator {
     return loop_states;
   }
   inline int64_t getPreviousSlice() const { return previous_slice; }
+  // Memory state after computing the last term.
+  inline const Memory& getLastState() const { return tmp_state; }
+  // Check whether all cells of the last state are the same as in a regular
+  // evaluation, and not only the output cells.
+  bool isLastStateComplete() const;
   bool isInputDependent(const Operand& op) const;
 
  private:
+  // Cached results of the static code analysis of a program.
+  struct Analysis {
+    Program program;
+    bool skip_input_transform;
+    bool is_supported;
+    SimpleLoopProgram simple_loop;
+    Program pre_loop_filtered;
+    std::set<int64_t> output_cells;
+    std::set<int64_t> stateful_cells;
+    std::set<int64_t> input_dependent_cells;
+    std::set<int64_t> loop_counter_dependent_cells;
+    int64_t loop_counter_decrement;
+    int64_t loop_counter_lower_bound;
+    Operation::Type loop_counter_type;
+  };
+
+  bool analyze(const Program& program, bool skip_input_transform);
+  void saveAnalysis(Analysis& analysis) const;
+  void loadAnalysis(const Analysis& analysis);
   bool checkPreLoop(bool skip_input_transform);
   bool checkLoopBody();
   bool checkPostLoop();
@@ -81,6 +117,7 @@ class IncrementalEvaluator {
   Operation::Type loop_counter_type;
   bool initialized;
   const bool is_debug;
+  std::unordered_map<size_t, Analysis> analysis_cache;
 
   // runtime data
   int64_t argument;
@@ -0,0 +1,246 @@
+#include "eval/evaluator_mat.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "eval/semantics.hpp"
+
+MatrixEvaluator::MatrixEvaluator(Interpreter& interpreter)
+    : interpreter(interpreter), counter_decrement(0), initialized(false) {}
+
+bool MatrixEvaluator::init(const Program& program) {
+  initialized = false;
+  simple_loop = Analyzer::extractSimpleLoop(program, true, false);
+  if (!simple_loop.is_simple_loop || !buildTransition()) {
+    return false;
+  }
+  initialized = true;
+  return true;
+}
+
+int64_t MatrixEvaluator::getIndex(int64_t cell) const {
+  return std::find(cells.begin(), cells.end(), cell) - cells.begin();
+}
+
+bool MatrixEvaluator::buildTransition() {
+  // collect the used cells and check the loop counter
+  cells.clear();
+  counter_decrement = 0;
+  for (const auto& op : simple_loop.body.ops) {
+    const auto target = op.target.value.asInt();
+    if (target == simple_loop.counter) {
+      if (op.type != Operation::Type::SUB ||
+          op.source.type != Operand::Type::CONSTANT || counter_decrement ||
+          op.source.value < Number::ONE) {
+        return false;
+      }
+      counter_decrement = op.source.value.asInt();
+      continue;
+    }
+    switch (op.type) {
+      case Operation::Type::MOV:
+      case Operation::Type::ADD:
+      case Operation::Type::SUB:
+        break;
+      case Operation::Type::MUL:
+        if (op.source.type != Operand::Type::CONSTANT) {
+          return false;
+        }
+        break;
+      default:
+        return false;
+    }
+    if (op.source.type == Operand::Type::DIRECT) {
+      const auto source = op.source.value.asInt();
+      if (source == simple_loop.counter) {
+        return false;
+      }
+      if (getIndex(source) == static_cast<int64_t>(cells.size())) {
+        cells.push_back(source);
+      }
+    }
+    if (getIndex(target) == static_cast<int64_t>(cells.size())) {
+      cells.push_back(target);
+    }
+  }
+  if (!counter_decrement) {
+    return false;
+  }
+
+  // the last row and column are used for constants
+  const size_t n = cells.size() + 1;
+  transition.assign(n, std::vector<Number>(n, Number::ZERO));
+  for (size_t i = 0; i < n; i++) {
+    transition[i][i] = Number::ONE;
+  }
+  step_bound = transition;
+  for (const auto& op : simple_loop.body.ops) {
+    const auto target = op.target.value.asInt();
+    if (target == simple_loop.counter) {
+      continue;
+    }
+    auto& row = transition[getIndex(target)];
+    std::vector<Number> src(n, Number::ZERO);
+    if (op.source.type == Operand::Type::DIRECT) {
+      src = transition[getIndex(op.source.value.asInt())];
+    } else {
+      src[n - 1] = op.source.value;
+    }
+    for (size_t j = 0; j < n; j++) {
+      switch (op.type) {
+        case Operation::Type::MOV:
+          row[j] = src[j];
+          break;
+        case Operation::Type::ADD:
+          row[j] = Semantics::add(row[j], src[j]);
+          break;
+        case Operation::Type::SUB:
+          row[j] = Semantics::sub(row[j], src[j]);
+          break;
+        case Operation::Type::MUL:
+          row[j] = Semantics::mul(row[j], op.source.value);
+          break;
+        default:
+          return false;
+      }
+      step_bound[getIndex(target)][j] = Semantics::max(
+          step_bound[getIndex(target)][j], Semantics::abs(row[j]));
+    }
+  }
+  // block matrix [[|T|, 0], [I, I]], whose k-th power contains the sum of
+  // the first k powers of |T| in the lower left block
+  growth.assign(2 * n, std::vector<Number>(2 * n, Number::ZERO));
+  for (size_t i = 0; i < n; i++) {
+    for (size_t j = 0; j < n; j++) {
+      growth[i][j] = Semantics::abs(transition[i][j]);
+    }
+    growth[n + i][i] = Number::ONE;
+    growth[n + i][n + i] = Number::ONE;
+  }
+  return true;
+}
+
+MatrixEvaluator::Matrix MatrixEvaluator::multiply(const Matrix& a,
+                                                  const Matrix& b) const {
+  const size_t n = a.size();
+  Matrix c(n, std::vector<Number>(n, Number::ZERO));
+  for (size_t i = 0; i < n; i++) {
+    for (size_t k = 0; k < n; k++) {
+      if (a[i][k] == Number::ZERO) {
+        continue;
+      }
+      for (size_t j = 0; j < n; j++) {
+        c[i][j] = Semantics::add(c[i][j], Semantics::mul(a[i][k], b[k][j]));
+      }
+    }
+  }
+  return c;
+}
+
+MatrixEvaluator::Matrix MatrixEvaluator::power(Matrix m, int64_t exp) const {
+  const size_t n = m.size();
+  Matrix result(n, std::vector<Number>(n, Number::ZERO));
+  for (size_t i = 0; i < n; i++) {
+    result[i][i] = Number::ONE;
+  }
+  while (exp > 0) {
+    if (exp & 1) {
+      result = multiply(result, m);
+    }
+    exp >>= 1;
+    if (exp > 0) {
+      m = multiply(m, m);
+    }
+  }
+  return result;
+}
+
+bool MatrixEvaluator::eval(const Number& arg,
+                           std::pair<Number, size_t>& result) {
+  if (!initialized) {
+    throw std::runtime_error("matrix evaluator not initialized");
+  }
+  // execute pre-loop code
+  Memory mem;
+  mem.set(Program::INPUT_CELL, arg);
+  size_t steps = interpreter.run(simple_loop.pre_loop, mem);
+
+  // number of iterations that are not reverted
+  const Number counter = mem.get(simple_loop.counter);
+  int64_t num_iterations = 0;
+  if (!(counter < Number::ZERO)) {
+    try {
+      num_iterations = counter.asInt() / counter_decrement;
+    } catch (const std::exception&) {
+      return false;
+    }
+  }
+
+  // lpb is executed once, the body and lpe once per iteration
+  const size_t body_steps = simple_loop.body.ops.size() + 1;
+  const size_t max_cycles = interpreter.getMaxCycles();
+  if (steps >= max_cycles ||
+      static_cast<size_t>(num_iterations) + 1 >
+          (max_cycles - steps - 1) / body_steps) {
+    throw std::runtime_error("Exceeded maximum number of steps (" +
+                             std::to_string(max_cycles) + ")");
+  }
+  steps += 1 + (num_iterations + 1) * body_steps;
+
+  const size_t n = cells.size();
+  std::vector<Number> state(n + 1);
+  for (size_t i = 0; i < n; i++) {
+    state[i] = mem.get(cells[i]);
+  }
+  state[n] = Number::ONE;
+
+  // bound the absolute values of all intermediate results: the states of
+  // all iterations are bounded by the sum of |T|^j*|s| for j=0..k
+  const auto g = power(growth, num_iterations + 1);
+  std::vector<Number> bound(n + 1, Number::ZERO);
+  for (size_t i = 0; i <= n; i++) {
+    for (size_t j = 0; j <= n; j++) {
+      bound[i] = Semantics::add(
+          bound[i],
+          Semantics::mul(g[n + 1 + i][j], Semantics::abs(state[j])));
+    }
+  }
+  for (size_t i = 0; i < n; i++) {
+    Number value = Number::ZERO;
+    for (size_t j = 0; j <= n; j++) {
+      value = Semantics::add(value, Semantics::mul(step_bound[i][j], bound[j]));
+    }
+    if (value == Number::INF) {
+      return false;
+    }
+  }
+
+  // apply the transition matrix
+  const auto m = power(transition, num_iterations);
+  for (size_t i = 0; i < n; i++) {
+    Number value = Number::ZERO;
+    for (size_t j = 0; j <= n; j++) {
+      value = Semantics::add(value, Semantics::mul(m[i][j], state[j]));
+    }
+    if (value == Number::INF) {
+      return false;
+    }
+    mem.set(cells[i], value);
+  }
+  mem.set(simple_loop.counter,
+          Semantics::sub(counter, Number(num_iterations * counter_decrement)));
+
+  // the last iteration is executed and reverted
+  Memory tmp = mem;
+  interpreter.run(simple_loop.body, tmp);
+
+  // execute post-loop code
+  steps += interpreter.run(simple_loop.post_loop, mem);
+  if (steps > max_cycles) {
+    throw std::runtime_error("Exceeded maximum number of steps (" +
+                             std::to_string(max_cycles) + ")");
+  }
+  result.first = mem.get(Program::OUTPUT_CELL);
+  result.second = steps;
+  return true;
+}
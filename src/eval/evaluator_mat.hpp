@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "eval/interpreter.hpp"
+#include "lang/analyzer.hpp"
+
+// Matrix Evaluator for simple loop programs whose loop bodies are affine maps
+// of the used memory cells, e.g. Fibonacci-like recurrences. Only mov, add and
+// sub using cells or constants and mul by constants are allowed in the loop
+// body, and the loop counter must be decremented by a constant. The loop is
+// evaluated by exponentiation of its transition matrix, so that a single term
+// can be computed using O(k^3 log n) number operations, where k is the number
+// of used cells. The step count is computed analytically. Since intermediate
+// values are not computed, they are bounded using the absolute values of the
+// matrix entries to detect overflows like the interpreter does.
+//
+// To find out whether your program is supported, use the init() function. If
+// it returns true, use eval() to compute terms for arbitrary arguments.
+//
+class MatrixEvaluator {
+ public:
+  explicit MatrixEvaluator(Interpreter& interpreter);
+
+  // Initialize the evaluator using a program. It can be applied only if this
+  // function returns true.
+  bool init(const Program& program);
+
+  // Compute the term and the step count for the given argument (the value of
+  // the input cell). Returns false if the result cannot be computed using
+  // matrix exponentiation, e.g., because of an overflow.
+  bool eval(const Number& arg, std::pair<Number, size_t>& result);
+
+ private:
+  using Matrix = std::vector<std::vector<Number>>;
+
+  bool buildTransition();
+  Matrix multiply(const Matrix& a, const Matrix& b) const;
+  Matrix power(Matrix m, int64_t exp) const;
+  int64_t getIndex(int64_t cell) const;
+
+  Interpreter& interpreter;
+  SimpleLoopProgram simple_loop;
+  std::vector<int64_t> cells;
+  Matrix transition;
+  // [[|T|, 0], [I, I]] for the transition matrix T, whose powers bound the
+  // states of all iterations
+  Matrix growth;
+  // bound of the absolute values of the operations of the loop body
+  Matrix step_bound;
+  int64_t counter_decrement;
+  bool initialized;
+};
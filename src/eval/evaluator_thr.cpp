@@ -0,0 +1,99 @@
+#include "eval/evaluator_thr.hpp"
+
+#include <atomic>
+#include <thread>
+
+#include "lang/program_util.hpp"
+
+// number of terms handed out to a thread at once
+static constexpr int64_t CHUNK_SIZE = 16;
+
+ThreadedEvaluator::ThreadedEvaluator(const Settings &settings,
+                                     size_t num_threads)
+    : settings(settings), num_threads(num_threads) {
+  this->settings.use_term_store = false;
+  for (size_t t = 0; t < num_threads; t++) {
+    interpreters.emplace_back(new Interpreter(this->settings));
+  }
+}
+
+void ThreadedEvaluator::eval(
+    const Program &p, int64_t num_terms, int64_t id, const Sequence &expected,
+    std::chrono::time_point<std::chrono::steady_clock> start_time,
+    Result &result) {
+  result.terms.assign(num_terms, Number::ZERO);
+  result.steps.assign(num_terms, 0);
+  std::vector<std::exception_ptr> errors(num_terms);
+  std::vector<uint8_t> has_steps(num_terms, false);
+  const int64_t offset = ProgramUtil::getOffset(p);
+  const bool check_eval_time = settings.max_eval_secs >= 0;
+  const bool check_expected = !expected.empty();
+  std::atomic<int64_t> next_chunk(0);
+  std::atomic<int64_t> num_ok(num_terms);  // index of first failed term
+
+  // mark a term as failed unless an earlier term failed already
+  auto fail = [&](int64_t i) {
+    int64_t current = num_ok.load();
+    while (i < current && !num_ok.compare_exchange_weak(current, i)) {
+    }
+  };
+
+  auto worker = [&](Interpreter &interpreter) {
+    Memory mem;
+    while (true) {
+      const int64_t start = next_chunk.fetch_add(CHUNK_SIZE);
+      if (start >= num_ok.load()) {
+        break;
+      }
+      const int64_t end = std::min(start + CHUNK_SIZE, num_terms);
+      for (int64_t i = start; i < end && i < num_ok.load(); i++) {
+        try {
+          mem.clear();
+          mem.set(Program::INPUT_CELL, i + offset);
+          result.steps[i] = interpreter.run(p, mem, id);
+          result.terms[i] = mem.get(Program::OUTPUT_CELL);
+          has_steps[i] = true;
+          if (check_eval_time &&
+              std::chrono::duration_cast<std::chrono::milliseconds>(
+                  std::chrono::steady_clock::now() - start_time)
+                      .count() > 1000 * settings.max_eval_secs) {
+            throw std::runtime_error("maximum evaluation time exceeded");
+          }
+        } catch (...) {
+          errors[i] = std::current_exception();
+          fail(i);
+          break;
+        }
+        if (check_expected && result.terms[i] != expected[i]) {
+          fail(i);
+          break;
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < num_threads; t++) {
+    threads.emplace_back(worker, std::ref(*interpreters[t]));
+  }
+  worker(*interpreters[0]);
+  for (auto &t : threads) {
+    t.join();
+  }
+  result.num_evaluated = num_ok.load();
+  const bool failed = result.num_evaluated < static_cast<size_t>(num_terms);
+  result.error = failed ? errors[result.num_evaluated] : nullptr;
+  result.has_failed_steps = failed && has_steps[result.num_evaluated];
+}
+
+void ThreadedEvaluator::invalidateCaches(int64_t id) {
+  for (auto &interpreter : interpreters) {
+    interpreter->invalidateCaches(id);
+  }
+}
+
+void ThreadedEvaluator::clearCaches() {
+  for (auto &interpreter : interpreters) {
+    interpreter->clearCaches();
+  }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <exception>
+#include <memory>
+
+#include "eval/interpreter.hpp"
+#include "math/sequence.hpp"
+
+// Evaluates the terms of a program in parallel using multiple threads, where
+// every thread uses its own interpreter. This works for programs where the
+// terms are computed independently of each other, i.e., for programs that are
+// not evaluated incrementally. The terms are handed out in small chunks to
+// the next idle thread, so that slow terms do not block the other threads.
+// The evaluation stops at the first failed term, i.e., if an error occurs or
+// if a term differs from the expected sequence. All terms before the failed
+// term are evaluated, so the results are the same as in a sequential
+// evaluation.
+class ThreadedEvaluator {
+ public:
+  // Results of the evaluated terms. The terms and steps are valid up to and
+  // including the failed term, unless the interpreter failed to evaluate it.
+  struct Result {
+    Sequence terms;
+    std::vector<size_t> steps;
+    size_t num_evaluated;  // index of the failed term or number of terms
+    std::exception_ptr error;
+    bool has_failed_steps;  // steps of the failed term are valid
+  };
+
+  ThreadedEvaluator(const Settings &settings, size_t num_threads);
+
+  // Evaluate the terms with the given indices. If expected is non-empty, the
+  // evaluation stops at the first term that does not match. The evaluation
+  // time is checked using the given start time.
+  void eval(const Program &p, int64_t num_terms, int64_t id,
+            const Sequence &expected,
+            std::chrono::time_point<std::chrono::steady_clock> start_time,
+            Result &result);
+
+  void invalidateCaches(int64_t id);
+
+  void clearCaches();
+
+  size_t getNumThreads() const { return num_threads; }
+
+ private:
+  // interpreters use their own copy of the settings without a shared term
+  // store, because it is not thread-safe
+  Settings settings;
+  const size_t num_threads;
+  std::vector<std::unique_ptr<Interpreter>> interpreters;
+};
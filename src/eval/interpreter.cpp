@@ -7,10 +7,13 @@
 #include <sstream>
 #include <stack>
 
+#include "eval/evaluator_inc.hpp"
+#include "eval/evaluator_mat.hpp"
 #include "eval/semantics.hpp"
-#include "lang/parser.hpp"
 #include "lang/program.hpp"
+#include "lang/program_store.hpp"
 #include "lang/program_util.hpp"
+#include "oeis/oeis_program.hpp"
 #include "oeis/oeis_sequence.hpp"
 #include "sys/log.hpp"
 #include "sys/setup.hpp"
@@ -33,7 +36,13 @@ Interpreter::Interpreter(const Settings& settings)
     : settings(settings),
       is_debug(Log::get().level == Log::Level::DEBUG),
       has_memory(true),
-      num_memory_checks(0) {}
+      num_memory_checks(0),
+      store_version(ProgramStore::get().getVersion()),
+      store_refreshes(ProgramStore::get().getNumRefreshes()),
+      term_store(settings.use_term_store ? &TermStore::get() : nullptr),
+      seq_terms_provider(nullptr) {}
+
+Interpreter::~Interpreter() {}
 
 Number Interpreter::calc(const Operation::Type type, const Number& target,
                          const Number& source) {
@@ -140,6 +149,11 @@ bool needsFragments(const Program& p) {
 }
 
 size_t Interpreter::run(const Program& p, Memory& mem) {
+  return resume(p, mem, 0, 0);
+}
+
+size_t Interpreter::resume(const Program& p, Memory& mem, size_t pc,
+                           size_t cycles) {
   // check for empty program
   if (p.ops.empty()) {
     return 0;
@@ -152,18 +166,15 @@ size_t Interpreter::run(const Program& p, Memory& mem) {
   MemStack mem_stack;
   MemStack frag_stack;
 
-  size_t cycles = 0;
   const size_t max_cycles = getMaxCycles();
   const bool needs_frags = needsFragments(p);
   const size_t num_ops = p.ops.size();
   Memory old_mem, frag;
-  size_t pc;
   Number source, target, counter;
   int64_t start, length, length2;
   Operation lpb;
 
   // start program execution
-  pc = 0;
   while (pc < num_ops) {
     if (is_debug) {
       old_mem = mem;
@@ -236,7 +247,8 @@ size_t Interpreter::run(const Program& p, Memory& mem) {
       case Operation::Type::SEQ: {
         target = get(op.target, mem);
         source = get(op.source, mem);
-        auto result = callSeq(source.asInt(), target);
+        auto result = callSeq(source.asInt(), target,
+                              max_cycles - std::min(max_cycles, cycles));
         set(op.target, result.first, mem, op);
         cycles += result.second;
         break;
@@ -388,15 +400,8 @@ void Interpreter::set(const Operand& a, const Number& v, Memory& mem,
   mem.set(index, v);
 }
 
-std::string getProgramPath(int64_t id) {
-  if (id < 0) {
-    return ProgramUtil::getProgramPath(-id, "prg", "P");
-  } else {
-    return ProgramUtil::getProgramPath(id);
-  }
-}
-
-std::pair<Number, size_t> Interpreter::callSeq(int64_t id, const Number& arg) {
+std::pair<Number, size_t> Interpreter::callSeq(int64_t id, const Number& arg,
+                                               size_t budget) {
   if (arg < 0) {
     throw std::runtime_error(ERROR_SEQ_USING_NEGATIVE_ARG);
   }
@@ -416,18 +421,40 @@ std::pair<Number, size_t> Interpreter::callSeq(int64_t id, const Number& arg) {
     throw std::runtime_error("Recursion detected: " + ProgramUtil::idStr(id));
   }
 
-  // evaluate program
+  // check if known from the provider, which is looked up first to skip also
+  // the incremental evaluation; skipped if a running program replaces a
+  // dependency of the called program
   std::pair<Number, size_t> result;
-  running_programs.insert(id);
-  Memory tmp;
-  tmp.set(Program::INPUT_CELL, arg);
-  try {
-    result.second = run(call_program, tmp);
-    result.first = tmp.get(Program::OUTPUT_CELL);
-    running_programs.erase(id);
-  } catch (...) {
-    running_programs.erase(id);
-    std::rethrow_exception(std::current_exception());
+  const bool use_stores =
+      (seq_terms_provider || term_store) && !dependsOnRunningProgram(id);
+  if (use_stores && seq_terms_provider &&
+      seq_terms_provider->getTerm(id, arg, result)) {
+    return result;
+  }
+
+  // use incremental evaluation if supported by the called program
+  if (callSeqInc(id, arg, budget, result)) {
+    return result;
+  }
+
+  // check if stored by this or another process
+  const bool is_stored =
+      use_stores && term_store &&
+      term_store->lookup(id, getProgramHash(id), arg, result);
+
+  // evaluate program
+  if (!is_stored) {
+    running_programs.insert(id);
+    Memory tmp;
+    tmp.set(Program::INPUT_CELL, arg);
+    try {
+      result.second = run(call_program, tmp);
+      result.first = tmp.get(Program::OUTPUT_CELL);
+      running_programs.erase(id);
+    } catch (...) {
+      running_programs.erase(id);
+      std::rethrow_exception(std::current_exception());
+    }
   }
 
   // add to cache if there is memory available
@@ -436,10 +463,98 @@ std::pair<Number, size_t> Interpreter::callSeq(int64_t id, const Number& arg) {
   }
   if (has_memory || terms_cache.size() < 10000) {  // magic number
     terms_cache[key] = result;
+    cached_ids.insert(id);
+  }
+  if (term_store && use_stores && !is_stored) {
+    term_store->store(id, getProgramHash(id), arg, result);
   }
   return result;
 }
 
+bool Interpreter::callSeqInc(int64_t id, const Number& arg, size_t budget,
+                             std::pair<Number, size_t>& result) {
+  // limit the size of the dense terms arrays and the number of terms that
+  // are computed in advance; magic numbers
+  static constexpr int64_t MAX_INC_CALL_TERMS = 100000;
+  static constexpr size_t MAX_INC_CALL_AHEAD = 1000;
+  static constexpr size_t MAX_INC_CALLS = 100;
+  auto it = inc_calls.find(id);
+  if (it == inc_calls.end()) {
+    // bounded like the terms cache if there is no memory available
+    if (!has_memory && inc_calls.size() >= MAX_INC_CALLS) {
+      return false;
+    }
+    auto& call_program = getProgram(id);
+    auto& call = inc_calls[id];
+    call.inc_evaluator.reset(new IncrementalEvaluator(*this));
+    if (!call.inc_evaluator->init(call_program)) {
+      call.inc_evaluator.reset();
+    }
+    call.mat_evaluator.reset(new MatrixEvaluator(*this));
+    if (!call.mat_evaluator->init(call_program)) {
+      call.mat_evaluator.reset();
+    }
+    call.offset = ProgramUtil::getOffset(call_program);
+    it = inc_calls.find(id);
+    cached_ids.insert(id);
+  }
+  auto& call = it->second;
+  Number index(arg);
+  index -= Number(call.offset);
+  if (!(index < Number::ZERO) && index < Number(MAX_INC_CALL_TERMS)) {
+    const size_t i = index.asInt();
+    // compute all terms up to the requested one, unless it is far ahead; the
+    // steps of the skipped terms are limited by the budget of the caller, so
+    // that the requested term is evaluated individually if it is exceeded
+    if (i >= call.terms.size() && call.inc_evaluator &&
+        i < call.terms.size() + MAX_INC_CALL_AHEAD) {
+      running_programs.insert(id);
+      bool failed = false;
+      try {
+        while (call.terms.size() <= i) {
+          call.terms.push_back(call.inc_evaluator->next());
+          const size_t steps = call.terms.back().second;
+          if (call.terms.size() <= i) {
+            if (steps > budget) {
+              break;
+            }
+            budget -= steps;
+          }
+        }
+      } catch (const std::exception&) {
+        failed = true;
+      }
+      running_programs.erase(id);
+      if (failed) {
+        if (dependsOnRunningProgram(id) || Signals::HALT) {
+          // transient error, e.g. a recursion via the currently checked
+          // program: start over with a new incremental evaluator next time
+          inc_calls.erase(it);
+          return false;
+        }
+        // use other evaluation methods for the remaining terms
+        call.inc_evaluator.reset();
+      }
+    }
+    if (i < call.terms.size()) {
+      result = call.terms[i];
+      return true;
+    }
+  }
+  if (call.mat_evaluator) {
+    running_programs.insert(id);
+    try {
+      const bool success = call.mat_evaluator->eval(arg, result);
+      running_programs.erase(id);
+      return success;
+    } catch (...) {
+      running_programs.erase(id);
+      std::rethrow_exception(std::current_exception());
+    }
+  }
+  return false;
+}
+
 size_t Interpreter::callPrg(int64_t id, int64_t start, Memory& mem) {
   // load program
   id = -id;  // internally use negative IDs for prg calls
@@ -447,7 +562,8 @@ size_t Interpreter::callPrg(int64_t id, int64_t start, Memory& mem) {
 
   // check for recursive calls
   if (running_programs.find(id) != running_programs.end()) {
-    throw std::runtime_error("Recursion detected: " + getProgramPath(id));
+    throw std::runtime_error("Recursion detected: " +
+                             ProgramStore::getProgramPath(id));
   }
 
   // get number of inputs and outputs
@@ -480,18 +596,33 @@ size_t Interpreter::callPrg(int64_t id, int64_t start, Memory& mem) {
 
 const Program& Interpreter::getProgram(int64_t id) {
   if (missing_programs.find(id) != missing_programs.end()) {
-    throw std::runtime_error("Program not found: " + getProgramPath(id));
+    throw std::runtime_error("Program not found: " +
+                             ProgramStore::getProgramPath(id));
   }
-  if (program_cache.find(id) == program_cache.end()) {
-    try {
-      Parser parser;
-      program_cache[id] = parser.parse(getProgramPath(id));
-    } catch (...) {
-      missing_programs.insert(id);
-      std::rethrow_exception(std::current_exception());
-    }
+  auto it = program_cache.find(id);
+  if (it != program_cache.end()) {
+    return *it->second;
   }
-  return program_cache[id];
+  try {
+    auto p = ProgramStore::get().getProgram(id);
+    program_cache[id] = p;
+    return *p;
+  } catch (...) {
+    missing_programs.insert(id);
+    std::rethrow_exception(std::current_exception());
+  }
+}
+
+size_t Interpreter::getProgramHash(int64_t id) {
+  auto it = program_hashes.find(id);
+  if (it != program_hashes.end()) {
+    return it->second;
+  }
+  // include the memory limit because it can change the result
+  size_t hash = OeisProgram::getTransitiveProgramHash(getProgram(id)) ^
+                static_cast<size_t>(settings.max_memory);
+  program_hashes[id] = hash;
+  return hash;
 }
 
 size_t Interpreter::getMaxCycles() const {
@@ -499,8 +630,119 @@ size_t Interpreter::getMaxCycles() const {
                                     : std::numeric_limits<size_t>::max();
 }
 
+const std::unordered_set<int64_t>& Interpreter::getProgramDeps(int64_t id) {
+  auto it = program_deps.find(id);
+  if (it != program_deps.end()) {
+    return it->second;
+  }
+  // collect the transitively called programs, including the program itself
+  std::unordered_set<int64_t> deps;
+  std::vector<int64_t> stack = {id};
+  while (!stack.empty()) {
+    const auto next = stack.back();
+    stack.pop_back();
+    if (!deps.insert(next).second) {
+      continue;
+    }
+    try {
+      for (auto& op : getProgram(next).ops) {
+        if (op.type == Operation::Type::SEQ &&
+            op.source.type == Operand::Type::CONSTANT) {
+          stack.push_back(op.source.value.asInt());
+        }
+      }
+    } catch (const std::exception&) {
+      // missing programs have no dependencies
+    }
+  }
+  return program_deps[id] = std::move(deps);
+}
+
+bool Interpreter::dependsOnRunningProgram(int64_t id) {
+  if (running_programs.empty()) {
+    return false;
+  }
+  const auto& deps = getProgramDeps(id);
+  for (auto running : running_programs) {
+    if (deps.find(running) != deps.end()) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void Interpreter::clearCaches() {
   missing_programs.clear();
   program_cache.clear();
+  program_hashes.clear();
+  program_deps.clear();
+  cached_ids.clear();
   terms_cache.clear();
+  inc_calls.clear();
+}
+
+void Interpreter::clearMissingPrograms() {
+  if (missing_programs.empty()) {
+    return;
+  }
+  // the dependencies of missing programs are incomplete
+  for (auto it = program_deps.begin(); it != program_deps.end();) {
+    bool has_missing = false;
+    for (auto missing : missing_programs) {
+      if (it->second.find(missing) != it->second.end()) {
+        has_missing = true;
+        break;
+      }
+    }
+    if (has_missing) {
+      it = program_deps.erase(it);
+    } else {
+      it++;
+    }
+  }
+  missing_programs.clear();
+}
+
+void Interpreter::invalidateCaches(int64_t id) {
+  // reload everything if program files were updated
+  ProgramStore::get().refresh();
+  const auto version = ProgramStore::get().getVersion();
+  if (version != store_version) {
+    clearCaches();
+    store_version = version;
+    store_refreshes = ProgramStore::get().getNumRefreshes();
+    return;
+  }
+  // look up missing programs again, because they could have been added
+  const auto refreshes = ProgramStore::get().getNumRefreshes();
+  if (refreshes != store_refreshes ||
+      (id >= 0 && missing_programs.find(id) != missing_programs.end())) {
+    clearMissingPrograms();
+    store_refreshes = refreshes;
+  }
+  if (id < 0) {
+    return;
+  }
+  // find the cached programs that call the given program
+  std::unordered_set<int64_t> dependents;
+  for (auto cached_id : cached_ids) {
+    const auto& deps = getProgramDeps(cached_id);
+    if (deps.find(id) != deps.end()) {
+      dependents.insert(cached_id);
+    }
+  }
+  if (dependents.empty()) {
+    return;
+  }
+  for (auto it = terms_cache.begin(); it != terms_cache.end();) {
+    if (dependents.find(it->first.first) != dependents.end()) {
+      it = terms_cache.erase(it);
+    } else {
+      it++;
+    }
+  }
+  for (auto dependent : dependents) {
+    cached_ids.erase(dependent);
+    inc_calls.erase(dependent);
+  }
 }
@@ -1,18 +1,35 @@
 #pragma once
 
+#include <memory>
 #include <unordered_map>
 #include <unordered_set>
 
 #include "eval/memory.hpp"
+#include "eval/term_store.hpp"
 #include "lang/program.hpp"
 #include "sys/util.hpp"
 
+// Source of known terms of sequences called via seq operations. If it returns
+// a term, the called program is not evaluated.
+class SeqTermsProvider {
+ public:
+  virtual ~SeqTermsProvider() {}
+
+  virtual bool getTerm(int64_t id, const Number &arg,
+                       std::pair<Number, size_t> &result) = 0;
+};
+
+class IncrementalEvaluator;
+class MatrixEvaluator;
+
 class Interpreter {
  public:
   static const std::string ERROR_SEQ_USING_NEGATIVE_ARG;
 
   explicit Interpreter(const Settings &settings);
 
+  ~Interpreter();
+
   static Number calc(const Operation::Type type, const Number &target,
                      const Number &source);
 
@@ -20,10 +37,28 @@ class Interpreter {
 
   size_t run(const Program &p, Memory &mem, int64_t id);
 
+  // Continues the execution of a program at the given operation. The memory
+  // and the number of steps must be the ones after executing the operations
+  // before, which must not contain loops.
+  size_t resume(const Program &p, Memory &mem, size_t pc, size_t cycles);
+
   size_t getMaxCycles() const;
 
   void clearCaches();
 
+  // Removes cached data that depends on the program with the given ID, so that
+  // a replacement of this program can be evaluated without clearing all
+  // caches. Also synchronizes with updated programs in the program store.
+  void invalidateCaches(int64_t id);
+
+  // IDs of the programs that are called by the given program, including
+  // transitive calls and the program itself.
+  const std::unordered_set<int64_t> &getProgramDeps(int64_t id);
+
+  void setSeqTermsProvider(SeqTermsProvider *provider) {
+    seq_terms_provider = provider;
+  }
+
  private:
   Number get(const Operand &a, const Memory &mem,
              bool get_address = false) const;
@@ -31,22 +66,53 @@ class Interpreter {
   void set(const Operand &a, const Number &v, Memory &mem,
            const Operation &last_op) const;
 
-  std::pair<Number, size_t> callSeq(int64_t id, const Number &arg);
+  // The budget is the number of remaining steps of the caller. It limits the
+  // steps of terms that are computed in advance.
+  std::pair<Number, size_t> callSeq(int64_t id, const Number &arg,
+                                    size_t budget);
+
+  bool callSeqInc(int64_t id, const Number &arg, size_t budget,
+                  std::pair<Number, size_t> &result);
 
   size_t callPrg(int64_t id, int64_t start, Memory &mem);
 
   const Program &getProgram(int64_t id);
 
+  size_t getProgramHash(int64_t id);
+
+  bool dependsOnRunningProgram(int64_t id);
+
+  // Forget missing programs and the dependencies that include them.
+  void clearMissingPrograms();
+
   const Settings &settings;
 
   const bool is_debug;
   bool has_memory;
   size_t num_memory_checks;
 
-  std::unordered_map<int64_t, Program> program_cache;
+  std::unordered_map<int64_t, std::shared_ptr<const Program>> program_cache;
   std::unordered_set<int64_t> missing_programs;
   std::unordered_set<int64_t> running_programs;
+  std::unordered_map<int64_t, size_t> program_hashes;
+  std::unordered_map<int64_t, std::unordered_set<int64_t>> program_deps;
+  std::unordered_set<int64_t> cached_ids;
+  size_t store_version;
+  size_t store_refreshes;
+  TermStore *term_store;
+  SeqTermsProvider *seq_terms_provider;
   std::unordered_map<std::pair<int64_t, Number>, std::pair<Number, size_t>,
                      IntNumberPairHasher>
       terms_cache;
+
+  // Called programs that support incremental or matrix evaluation. Terms
+  // computed incrementally are stored densely, indexed by the argument minus
+  // the offset. Matrix evaluation is used for other arguments.
+  struct IncCall {
+    std::unique_ptr<IncrementalEvaluator> inc_evaluator;
+    std::unique_ptr<MatrixEvaluator> mat_evaluator;
+    int64_t offset;
+    std::vector<std::pair<Number, size_t>> terms;
+  };
+  std::unordered_map<int64_t, IncCall> inc_calls;
 };
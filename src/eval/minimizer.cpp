@@ -5,6 +5,7 @@
 
 #include "eval/optimizer.hpp"
 #include "eval/semantics.hpp"
+#include "lang/analyzer.hpp"
 #include "lang/constants.hpp"
 #include "lang/program_util.hpp"
 #include "sys/file.hpp"
@@ -132,6 +133,12 @@ bool Minimizer::minimize(Program& p, size_t num_terms) const {
 
 bool Minimizer::check(const Program& p, const Sequence& seq,
                       size_t max_total) const {
+  // skip candidates that likely exceed the maximum number of cycles
+  const int64_t last_input =
+      static_cast<int64_t>(seq.size()) - 1 + ProgramUtil::getOffset(p);
+  if (Analyzer::estimateSteps(p).exceeds(last_input, settings.max_cycles)) {
+    return false;
+  }
   try {
     auto res = evaluator.check(p, seq);
     if (res.first != status_t::OK) {
@@ -0,0 +1,291 @@
+#include "eval/term_store.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "sys/log.hpp"
+#include "sys/setup.hpp"
+#include "sys/util.hpp"
+
+TermStore& TermStore::get() {
+  static TermStore store(Setup::getLodaHome() + "cache" + FILE_SEP +
+                         "terms_v1.bin");
+  return store;
+}
+
+TermStore::TermStore(const std::string& path, size_t max_records,
+                     std::chrono::milliseconds refresh_interval,
+                     size_t max_local_records)
+    : path(path),
+      index_path(path.substr(0, path.rfind('.')) + ".idx"),
+      max_records(max_records),
+      max_local_records(max_local_records),
+      refresh_interval(refresh_interval),
+      file(path),
+      index_file(index_path),
+      file_id(0),
+      num_mapped(0),
+      num_shared(0),
+      shared_capacity(0),
+      num_indexed(0),
+      num_records(0),
+      writable(true) {}
+
+std::size_t TermStore::KeyHasher::operator()(const Key& k) const {
+  // stable across processes, because it is used in the shared index
+  uint64_t h = k.hash;
+  for (uint64_t v : {static_cast<uint64_t>(k.id), static_cast<uint64_t>(k.arg)}) {
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h;
+}
+
+bool TermStore::toInt(const Number& n, int64_t& result) {
+  try {
+    result = n.asInt();
+  } catch (const std::exception&) {
+    return false;
+  }
+  return Number(result) == n;
+}
+
+TermStore::Record TermStore::getRecord(size_t pos) const {
+  Record r;
+  std::memcpy(&r, file.data() + (pos * sizeof(Record)), sizeof(Record));
+  return r;
+}
+
+bool TermStore::find(const Key& key, size_t& pos) const {
+  auto it = local_index.find(key);
+  if (it != local_index.end()) {
+    pos = it->second;
+    return true;
+  }
+  if (num_shared == 0) {
+    return false;
+  }
+  const auto slots = reinterpret_cast<const uint32_t*>(index_file.data() +
+                                                       sizeof(IndexHeader));
+  const size_t mask = shared_capacity - 1;
+  size_t i = KeyHasher()(key) & mask;
+  for (size_t n = 0; n < shared_capacity; n++, i = (i + 1) & mask) {
+    if (slots[i] == 0) {
+      return false;
+    }
+    pos = slots[i] - 1;
+    if (pos < num_shared) {
+      const auto r = getRecord(pos);
+      if (key == Key{r.id, r.hash, r.arg}) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void TermStore::refresh() {
+  next_refresh = std::chrono::steady_clock::now() + refresh_interval;
+  file.refresh();
+  num_mapped = file.size() / sizeof(Record);
+  num_records = num_mapped;
+  if (num_mapped < num_indexed || file.getFileId() != file_id) {
+    // the file was truncated or replaced => rebuild the indexes
+    local_index.clear();
+    num_indexed = 0;
+    num_shared = 0;
+    shared_capacity = 0;
+    file_id = file.getFileId();
+  }
+  useSharedIndex();
+  // the file is append-only, so we only need to index the new records
+  for (; num_indexed < num_mapped; num_indexed++) {
+    const auto r = getRecord(num_indexed);
+    local_index[{r.id, r.hash, r.arg}] = num_indexed;
+  }
+  if (writable && local_index.size() > max_local_records) {
+    writeSharedIndex();
+  }
+}
+
+void TermStore::useSharedIndex() {
+  index_file.refresh();
+  IndexHeader h;
+  size_t shared = 0, capacity = 0;
+  if (index_file.size() >= sizeof(IndexHeader)) {
+    std::memcpy(&h, index_file.data(), sizeof(IndexHeader));
+    // the index must belong to the current file
+    if (std::memcmp(h.tag, INDEX_TAG, sizeof(INDEX_TAG)) == 0 &&
+        h.file_id == file_id && h.num_records <= num_mapped &&
+        h.capacity > h.num_records && (h.capacity & (h.capacity - 1)) == 0 &&
+        index_file.size() ==
+            sizeof(IndexHeader) + h.capacity * sizeof(uint32_t)) {
+      shared = h.num_records;
+      capacity = h.capacity;
+    }
+  }
+  if (shared == num_shared && capacity == shared_capacity) {
+    return;
+  }
+  // the records not covered by the shared index are indexed locally
+  num_shared = shared;
+  shared_capacity = capacity;
+  local_index.clear();
+  num_indexed = num_shared;
+}
+
+void TermStore::writeSharedIndex() {
+  size_t capacity = 1024;
+  while (capacity < 2 * num_mapped) {
+    capacity *= 2;
+  }
+  // later records of the same key replace earlier ones
+  std::vector<uint32_t> slots(capacity, 0);
+  const size_t mask = capacity - 1;
+  for (size_t pos = 0; pos < num_mapped; pos++) {
+    const auto r = getRecord(pos);
+    const Key key{r.id, r.hash, r.arg};
+    for (size_t i = KeyHasher()(key) & mask;; i = (i + 1) & mask) {
+      if (slots[i] != 0) {
+        const auto o = getRecord(slots[i] - 1);
+        if (!(key == Key{o.id, o.hash, o.arg})) {
+          continue;
+        }
+      }
+      slots[i] = pos + 1;
+      break;
+    }
+  }
+  Log::get().debug("Writing term store index for " +
+                   std::to_string(num_mapped) + " records");
+  IndexHeader h;
+  std::memcpy(h.tag, INDEX_TAG, sizeof(INDEX_TAG));
+  h.file_id = file_id;
+  h.num_records = num_mapped;
+  h.capacity = capacity;
+  const std::string tmp =
+      index_path + ".tmp" + std::to_string(Random::get().gen() % 100000);
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char*>(slots.data()),
+              slots.size() * sizeof(uint32_t));
+    if (!out) {
+      Log::get().warn("Cannot write term store index: " + index_path);
+      std::remove(tmp.c_str());
+      writable = false;
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, index_path, ec);
+  if (ec) {
+    Log::get().warn("Cannot write term store index: " + index_path);
+    std::remove(tmp.c_str());
+    writable = false;
+    return;
+  }
+  useSharedIndex();
+}
+
+bool TermStore::lookup(int64_t id, size_t hash, const Number& arg,
+                       std::pair<Number, size_t>& result) {
+  int64_t a;
+  if (!toInt(arg, a)) {
+    return false;
+  }
+  const Key key{id, hash, a};
+  size_t pos;
+  if (!find(key, pos)) {
+    // check for records appended by other processes
+    if (std::chrono::steady_clock::now() < next_refresh) {
+      return false;
+    }
+    refresh();
+    if (!find(key, pos)) {
+      return false;
+    }
+  }
+  const auto r = getRecord(pos);
+  result.first = Number(r.value);
+  result.second = r.steps;
+  return true;
+}
+
+void TermStore::store(int64_t id, size_t hash, const Number& arg,
+                      const std::pair<Number, size_t>& result) {
+  Record r;
+  if (!writable || !toInt(arg, r.arg) || !toInt(result.first, r.value)) {
+    return;
+  }
+  if (num_records >= max_records) {
+    compact();
+    if (num_records >= max_records) {
+      return;
+    }
+  }
+  r.id = id;
+  r.hash = hash;
+  r.steps = result.second;
+  if (num_records == 0) {
+    ensureDir(path);
+  }
+  if (!appendToFile(path, &r, sizeof(Record))) {
+    Log::get().warn("Cannot write to term store: " + path);
+    writable = false;
+    return;
+  }
+  num_records++;
+}
+
+void TermStore::compact() {
+  refresh();
+  if (num_records < max_records) {
+    return;  // compacted by another process
+  }
+  // keep the latest record of every program argument; records of other
+  // program hashes were most likely invalidated by program updates
+  std::unordered_map<Key, size_t, KeyHasher> latest;
+  for (size_t i = 0; i < num_mapped; i++) {
+    const auto r = getRecord(i);
+    latest[{r.id, 0, r.arg}] = i;
+  }
+  std::vector<size_t> positions;
+  positions.reserve(latest.size());
+  for (const auto& e : latest) {
+    positions.push_back(e.second);
+  }
+  if (positions.size() > max_records / 2) {
+    positions.clear();  // start with an empty file
+  }
+  std::sort(positions.begin(), positions.end());
+  Log::get().debug("Compacting term store from " +
+                   std::to_string(num_mapped) + " to " +
+                   std::to_string(positions.size()) + " records");
+  const std::string tmp =
+      path + ".tmp" + std::to_string(Random::get().gen() % 100000);
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    for (auto i : positions) {
+      out.write(file.data() + (i * sizeof(Record)), sizeof(Record));
+    }
+    if (!out) {
+      Log::get().warn("Cannot compact term store: " + path);
+      std::remove(tmp.c_str());
+      writable = false;
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    Log::get().warn("Cannot compact term store: " + path);
+    std::remove(tmp.c_str());
+    writable = false;
+    return;
+  }
+  refresh();
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+
+#include "math/number.hpp"
+#include "sys/file.hpp"
+
+// Persistent store for evaluated terms of sequence programs. It maps
+// (program id, program hash, argument) to (value, steps). The data is stored
+// in an append-only binary file in the LODA home directory, which is shared
+// by all miner processes on a host and survives restarts. Entries of modified
+// programs are invalidated implicitly, because the program hash is part of
+// the key. Only terms that fit into 64-bit integers are stored. Lookups check
+// for records of other processes at most once per refresh interval. If the
+// file is full, it is compacted by keeping only the latest record of every
+// program argument.
+//
+// The records are indexed by an open-addressed hash table in a sidecar file,
+// which is memory-mapped and hence shared by all processes as well. Only the
+// records appended after the last update of the shared index are indexed per
+// process. If there are too many of them, the shared index is rebuilt.
+class TermStore {
+ public:
+  // magic numbers: limit the file size and the number of records that are
+  // indexed per process
+  static constexpr size_t MAX_RECORDS = 1600000;
+  static constexpr size_t MAX_LOCAL_RECORDS = 50000;
+  static constexpr std::chrono::milliseconds REFRESH_INTERVAL{1000};
+
+  static constexpr char INDEX_TAG[8] = {'L', 'O', 'D', 'A', 'T', 'I', 'X', '1'};
+
+  static TermStore& get();
+
+  explicit TermStore(
+      const std::string& path, size_t max_records = MAX_RECORDS,
+      std::chrono::milliseconds refresh_interval = REFRESH_INTERVAL,
+      size_t max_local_records = MAX_LOCAL_RECORDS);
+
+  bool lookup(int64_t id, size_t hash, const Number& arg,
+              std::pair<Number, size_t>& result);
+
+  void store(int64_t id, size_t hash, const Number& arg,
+             const std::pair<Number, size_t>& result);
+
+  // number of records covered by the shared index
+  size_t getNumSharedRecords() const { return num_shared; }
+
+  // number of records indexed by this process
+  size_t getNumLocalRecords() const { return local_index.size(); }
+
+ private:
+  struct Record {
+    int64_t id;
+    uint64_t hash;
+    int64_t arg;
+    int64_t value;
+    uint64_t steps;
+  };
+
+  struct Key {
+    int64_t id;
+    uint64_t hash;
+    int64_t arg;
+    bool operator==(const Key& k) const {
+      return id == k.id && hash == k.hash && arg == k.arg;
+    }
+  };
+
+  struct KeyHasher {
+    std::size_t operator()(const Key& k) const;
+  };
+
+  struct IndexHeader {
+    char tag[8];
+    uint64_t file_id;
+    uint64_t num_records;
+    uint64_t capacity;
+  };
+
+  static bool toInt(const Number& n, int64_t& result);
+
+  Record getRecord(size_t pos) const;
+
+  bool find(const Key& key, size_t& pos) const;
+
+  void refresh();
+
+  void useSharedIndex();
+
+  void writeSharedIndex();
+
+  void compact();
+
+  const std::string path;
+  const std::string index_path;
+  const size_t max_records;
+  const size_t max_local_records;
+  const std::chrono::milliseconds refresh_interval;
+  std::chrono::steady_clock::time_point next_refresh;
+  MappedFile file;
+  MappedFile index_file;
+  uint64_t file_id;
+  size_t num_mapped;   // number of records in the mapped file
+  size_t num_shared;   // number of records covered by the shared index
+  size_t shared_capacity;
+  size_t num_indexed;  // number of records covered by both indexes
+  size_t num_records;  // including the records appended since the refresh
+  bool writable;
+  std::unordered_map<Key, size_t, KeyHasher> local_index;
+};
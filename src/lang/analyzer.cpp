@@ -1,11 +1,17 @@
 #include "lang/analyzer.hpp"
 
 #include <algorithm>
+#include <cmath>
 
+#include "eval/interpreter.hpp"
+#include "lang/program_store.hpp"
 #include "lang/program_util.hpp"
 
-SimpleLoopProgram Analyzer::extractSimpleLoop(const Program& program) {
+SimpleLoopProgram Analyzer::extractSimpleLoop(const Program& program,
+                                              bool allow_post_loops,
+                                              bool allow_region) {
   SimpleLoopProgram result;
+  result.region_length = 1;
   int64_t phase = 0;
   for (auto& op : program.ops) {
     if (op.type == Operation::Type::NOP) {
@@ -15,12 +21,25 @@ SimpleLoopProgram Analyzer::extractSimpleLoop(const Program& program) {
       result.is_simple_loop = false;
       return result;
     }
+    // further loops are copied to the post-loop
+    if ((op.type == Operation::Type::LPB || op.type == Operation::Type::LPE) &&
+        phase == 2 && allow_post_loops) {
+      result.post_loop.ops.push_back(op);
+      continue;
+    }
     if (op.type == Operation::Type::LPB) {
       if (phase != 0 || op.target.type != Operand::Type::DIRECT ||
-          op.source != Operand(Operand::Type::CONSTANT, 1)) {
+          op.source.type != Operand::Type::CONSTANT) {
         result.is_simple_loop = false;
         return result;
       }
+      if (op.source.value != Number::ONE) {
+        if (!allow_region || op.source.value < Number::ONE) {
+          result.is_simple_loop = false;
+          return result;
+        }
+        result.region_length = op.source.value.asInt();
+      }
       result.counter = op.target.value.asInt();
       phase = 1;
       continue;
@@ -180,3 +199,598 @@ bool Analyzer::hasExponentialComplexity(const Program& program) {
   // success: program has exponential complexity
   return true;
 }
+
+// ====== Static estimation of execution steps ========
+
+Growth::Growth(Type type, int64_t degree) : type(type), degree(degree) {
+  if (type != Type::POLYNOMIAL) {
+    this->degree = 0;
+  } else if (degree <= 0) {
+    this->type = Type::CONSTANT;
+    this->degree = 0;
+  }
+}
+
+Growth Growth::max(const Growth& a, const Growth& b) {
+  return (a < b) ? b : a;
+}
+
+Growth Growth::min(const Growth& a, const Growth& b) {
+  if (a.type == Type::UNKNOWN) {
+    return b;
+  }
+  if (b.type == Type::UNKNOWN) {
+    return a;
+  }
+  return (a < b) ? a : b;
+}
+
+Growth Growth::product(const Growth& a, const Growth& b) {
+  if (a.type == Type::UNKNOWN || b.type == Type::UNKNOWN) {
+    return Growth(Type::UNKNOWN);
+  }
+  if (a.type == Type::POLYNOMIAL && b.type == Type::POLYNOMIAL) {
+    return Growth(Type::POLYNOMIAL, a.degree + b.degree);
+  }
+  // the larger class dominates, e.g. log(n)*n is approximated by n
+  return max(a, b);
+}
+
+Growth Growth::power(const Growth& a, int64_t exponent) {
+  if (exponent <= 0) {
+    return Growth(Type::CONSTANT);
+  }
+  if (a.type == Type::POLYNOMIAL) {
+    return Growth(Type::POLYNOMIAL, a.degree * std::min<int64_t>(exponent, 100));
+  }
+  return a;
+}
+
+Growth Growth::exp(const Growth& a) {
+  switch (a.type) {
+    case Type::CONSTANT:
+    case Type::UNKNOWN:
+      return a;
+    case Type::LOGARITHMIC:
+      return Growth(Type::POLYNOMIAL, 1);
+    case Type::POLYNOMIAL:
+    case Type::EXPONENTIAL:
+      break;
+  }
+  return Growth(Type::EXPONENTIAL);
+}
+
+Growth Growth::log(const Growth& a) {
+  switch (a.type) {
+    case Type::CONSTANT:
+    case Type::LOGARITHMIC:
+      return Growth(Type::CONSTANT);
+    case Type::POLYNOMIAL:
+      return Growth(Type::LOGARITHMIC);
+    case Type::EXPONENTIAL:
+      return Growth(Type::POLYNOMIAL, 1);
+    case Type::UNKNOWN:
+      break;
+  }
+  return a;
+}
+
+Growth Growth::divide(const Growth& a, const Growth& b) {
+  if (a.type == Type::UNKNOWN || b.type == Type::UNKNOWN ||
+      b.type == Type::CONSTANT) {
+    return a;
+  }
+  if (!(b < a)) {
+    return Growth(Type::CONSTANT);
+  }
+  if (a.type == Type::POLYNOMIAL && b.type == Type::POLYNOMIAL) {
+    return Growth(Type::POLYNOMIAL, a.degree - b.degree);
+  }
+  return a;
+}
+
+Growth Growth::compose(const Growth& a, const Growth& b) {
+  if (a.type == Type::CONSTANT || b.type == Type::CONSTANT) {
+    return Growth(Type::CONSTANT);
+  }
+  if (a.type == Type::UNKNOWN || b.type == Type::UNKNOWN) {
+    return Growth(Type::UNKNOWN);
+  }
+  switch (a.type) {
+    case Type::LOGARITHMIC:
+      return log(b);
+    case Type::POLYNOMIAL:
+      return power(b, a.degree);
+    case Type::EXPONENTIAL:
+      return exp(b);
+    default:
+      return a;
+  }
+}
+
+double Growth::evaluate(int64_t n) const {
+  const double m = std::max<int64_t>(n, 0) + 1;
+  switch (type) {
+    case Type::CONSTANT:
+      return 1;
+    case Type::LOGARITHMIC:
+      return std::log2(m + 1);
+    case Type::POLYNOMIAL:
+      return std::pow(m, degree);
+    case Type::EXPONENTIAL:
+      return std::pow(2.0, m);
+    case Type::UNKNOWN:
+      break;
+  }
+  return -1;
+}
+
+std::string Growth::toString() const {
+  switch (type) {
+    case Type::CONSTANT:
+      return "O(1)";
+    case Type::LOGARITHMIC:
+      return "O(log(n))";
+    case Type::POLYNOMIAL:
+      return degree == 1 ? "O(n)" : "O(n^" + std::to_string(degree) + ")";
+    case Type::EXPONENTIAL:
+      return "O(2^n)";
+    case Type::UNKNOWN:
+      break;
+  }
+  return "unknown";
+}
+
+double StepEstimate::evaluate(int64_t n) const {
+  if (growth.type == Growth::Type::UNKNOWN) {
+    return -1;
+  }
+  double result = 0;
+  for (const auto& t : terms) {
+    result += t.first.evaluate(n) * t.second;
+  }
+  return result;
+}
+
+bool StepEstimate::exceeds(int64_t n, int64_t max_steps) const {
+  // the estimate is not precise, so we use a large margin
+  static constexpr double MARGIN = 1000.0;  // magic number
+  return max_steps >= 0 && evaluate(n) > MARGIN * max_steps;
+}
+
+// Abstract interpretation of a program that tracks the growth of the values
+// of memory cells and counts the operations per growth class.
+class StepEstimator {
+ public:
+  static constexpr size_t MAX_CALL_DEPTH = 5;
+  static constexpr size_t MAX_CALLS = 20;
+
+  StepEstimator(std::vector<int64_t>& call_stack, size_t& num_calls)
+      : call_stack(call_stack), num_calls(num_calls), unknown(false) {}
+
+  void run(const Program& p) {
+    cells[Program::INPUT_CELL] = Growth(Growth::Type::POLYNOMIAL, 1);
+    process(p, 0, p.ops.size(), Growth(), Growth(), true);
+    if (unknown) {
+      result.growth = Growth(Growth::Type::UNKNOWN);
+    } else {
+      for (const auto& t : result.terms) {
+        result.growth = Growth::max(result.growth, t.first);
+      }
+    }
+    output = get(Operand(Operand::Type::DIRECT, Program::OUTPUT_CELL));
+  }
+
+  StepEstimate result;
+  Growth output;
+
+ private:
+  static bool getConstant(const Operand& op, int64_t& value) {
+    if (op.type != Operand::Type::CONSTANT ||
+        Number(std::numeric_limits<int64_t>::max()) < op.value ||
+        op.value < Number(std::numeric_limits<int64_t>::min())) {
+      return false;
+    }
+    value = op.value.asInt();
+    return true;
+  }
+
+  Growth get(const Operand& op) const {
+    if (op.type == Operand::Type::CONSTANT) {
+      return Growth();
+    }
+    if (op.type == Operand::Type::DIRECT) {
+      auto it = cells.find(op.value.asInt());
+      return (it == cells.end()) ? Growth() : it->second;
+    }
+    return Growth(Growth::Type::UNKNOWN);
+  }
+
+  void addTerm(const Growth& g, int64_t count) {
+    if (g.type == Growth::Type::UNKNOWN) {
+      unknown = true;
+    }
+    result.terms[g] += count;
+  }
+
+  static size_t findLoopEnd(const Program& p, size_t begin, size_t end) {
+    int64_t depth = 0;
+    for (size_t i = begin; i < end; i++) {
+      if (p.ops[i].type == Operation::Type::LPB) {
+        depth++;
+      } else if (p.ops[i].type == Operation::Type::LPE && --depth == 0) {
+        return i;
+      }
+    }
+    return end;
+  }
+
+  // Growth of the number of iterations of a loop based on the updates of the
+  // loop counter in the loop body.
+  Growth getIterations(const Program& p, size_t begin, size_t end,
+                       int64_t counter) const {
+    bool has_sub = false, has_div = false;
+    Growth decrement;
+    int64_t value = 0;
+    for (size_t i = begin; i < end; i++) {
+      const auto& op = p.ops[i];
+      const auto& meta = Operation::Metadata::get(op.type);
+      if (meta.num_operands == 0 || !meta.is_writing_target) {
+        continue;
+      }
+      if (op.target.type == Operand::Type::INDIRECT) {
+        return Growth(Growth::Type::UNKNOWN);
+      }
+      if (op.target.value != Number(counter)) {
+        continue;
+      }
+      const bool is_sub =
+          op.type == Operation::Type::SUB || op.type == Operation::Type::TRN;
+      const bool is_div =
+          op.type == Operation::Type::DIV || op.type == Operation::Type::DIF;
+      if (is_sub && getConstant(op.source, value) && value > 0) {
+        has_sub = true;
+      } else if (is_sub && op.source.type == Operand::Type::DIRECT) {
+        has_sub = true;
+        decrement = Growth::max(decrement, get(op.source));
+      } else if (is_div && getConstant(op.source, value) && value > 1) {
+        has_div = true;
+      } else {
+        return Growth(Growth::Type::UNKNOWN);
+      }
+    }
+    const auto counter_growth =
+        get(Operand(Operand::Type::DIRECT, Number(counter)));
+    if (has_div) {
+      return Growth::log(counter_growth);
+    } else if (has_sub) {
+      return Growth::divide(counter_growth, decrement);
+    }
+    // the loop is executed once if the counter is not updated
+    return Growth();
+  }
+
+  void process(const Program& p, size_t begin, size_t end, const Growth& mult,
+               const Growth& iterations, bool record) {
+    for (size_t pc = begin; pc < end; pc++) {
+      const auto& op = p.ops[pc];
+      if (op.type == Operation::Type::LPB) {
+        const size_t loop_end = findLoopEnd(p, pc, end);
+        if (op.target.type != Operand::Type::DIRECT) {
+          unknown = true;
+          pc = loop_end;
+          continue;
+        }
+        const auto loop_iterations =
+            getIterations(p, pc + 1, loop_end, op.target.value.asInt());
+        const auto loop_mult = Growth::product(mult, loop_iterations);
+        if (record) {
+          addTerm(loop_mult, 2);  // lpb and lpe
+        }
+        // the first pass propagates the growth of values between iterations
+        process(p, pc + 1, loop_end, loop_mult, loop_iterations, false);
+        process(p, pc + 1, loop_end, loop_mult, loop_iterations, record);
+        cells[op.target.value.asInt()] = Growth();
+        pc = loop_end;
+        continue;
+      }
+      if (record) {
+        addTerm(mult, 1);
+      }
+      if (op.type == Operation::Type::SEQ) {
+        callSeq(op, mult, record);
+      } else {
+        update(op, iterations);
+      }
+    }
+  }
+
+  void callSeq(const Operation& op, const Growth& mult, bool record) {
+    int64_t id = 0;
+    std::shared_ptr<const Program> callee;
+    if (getConstant(op.source, id) &&
+        std::find(call_stack.begin(), call_stack.end(), id) ==
+            call_stack.end() &&
+        call_stack.size() < MAX_CALL_DEPTH && num_calls < MAX_CALLS) {
+      try {
+        callee = ProgramStore::get().getProgram(id);
+      } catch (const std::exception&) {
+        // program not found
+      }
+    }
+    if (!callee) {
+      unknown = true;
+      cells[op.target.value.asInt()] = Growth(Growth::Type::UNKNOWN);
+      return;
+    }
+    num_calls++;
+    call_stack.push_back(id);
+    StepEstimator estimator(call_stack, num_calls);
+    estimator.run(*callee);
+    call_stack.pop_back();
+    const auto arg = get(op.target);
+    if (estimator.result.growth.type == Growth::Type::UNKNOWN) {
+      unknown = true;
+    }
+    if (record) {
+      for (const auto& t : estimator.result.terms) {
+        addTerm(Growth::product(mult, Growth::compose(t.first, arg)), t.second);
+      }
+    }
+    cells[op.target.value.asInt()] = Growth::compose(estimator.output, arg);
+  }
+
+  // Update the growth of the target cell of an operation. Values that are
+  // updated in loops accumulate over all iterations.
+  void update(const Operation& op, const Growth& iterations) {
+    const auto& meta = Operation::Metadata::get(op.type);
+    if (meta.num_operands == 0 || !meta.is_writing_target) {
+      return;
+    }
+    if (op.target.type != Operand::Type::DIRECT ||
+        op.source.type == Operand::Type::INDIRECT ||
+        op.type == Operation::Type::PRG) {
+      unknown = true;
+      return;
+    }
+    const int64_t target = op.target.value.asInt();
+    const auto t = get(op.target);
+    const auto s = get(op.source);
+    int64_t value = 0;
+    const bool is_constant = getConstant(op.source, value);
+    const bool in_loop = !(iterations == Growth());
+    Growth r;
+    switch (op.type) {
+      case Operation::Type::MOV:
+        r = s;
+        break;
+      case Operation::Type::ADD:
+      case Operation::Type::SUB:
+      case Operation::Type::TRN:
+        r = Growth::max(t, Growth::product(s, iterations));
+        break;
+      case Operation::Type::MUL:
+        r = Growth::product(t, s);
+        if (in_loop && !(is_constant && std::abs(value) <= 1)) {
+          r = Growth::max(r, Growth::exp(iterations));
+        }
+        break;
+      case Operation::Type::DIV:
+      case Operation::Type::DIF:
+        r = Growth::divide(t, s);
+        break;
+      case Operation::Type::MOD:
+        r = is_constant ? Growth() : Growth::min(t, s);
+        break;
+      case Operation::Type::POW:
+      case Operation::Type::BIN:
+        if (is_constant) {
+          r = Growth::power(t, value);
+        } else if (op.type == Operation::Type::POW) {
+          r = Growth::max(t, Growth::exp(s));
+        } else {
+          r = Growth::exp(Growth::min(t, s));
+        }
+        break;
+      case Operation::Type::NRT:
+        if (is_constant && value >= 2 && t.type == Growth::Type::POLYNOMIAL) {
+          r = Growth(Growth::Type::POLYNOMIAL, t.degree / value);
+        } else {
+          r = is_constant ? t : Growth::log(t);
+        }
+        break;
+      case Operation::Type::LOG:
+      case Operation::Type::LEX:
+      case Operation::Type::DGS:
+      case Operation::Type::DGR:
+        r = Growth::log(t);
+        break;
+      case Operation::Type::EQU:
+      case Operation::Type::NEQ:
+      case Operation::Type::LEQ:
+      case Operation::Type::GEQ:
+        r = Growth();
+        break;
+      case Operation::Type::GCD:
+      case Operation::Type::MIN:
+      case Operation::Type::BAN:
+        r = Growth::min(t, s);
+        break;
+      case Operation::Type::CLR:
+      case Operation::Type::SRT: {
+        if (!is_constant || value < 0 || value > 100) {
+          unknown = true;
+          return;
+        }
+        for (int64_t i = 0; i < value; i++) {
+          r = Growth::max(r, get(Operand(Operand::Type::DIRECT, target + i)));
+        }
+        if (op.type == Operation::Type::CLR) {
+          r = Growth();
+        }
+        for (int64_t i = 0; i < value; i++) {
+          cells[target + i] = r;
+        }
+        return;
+      }
+      default:
+        r = Growth::max(t, s);
+        break;
+    }
+    cells[target] = r;
+  }
+
+  std::vector<int64_t>& call_stack;
+  size_t& num_calls;
+  std::map<int64_t, Growth> cells;
+  bool unknown;
+};
+
+StepEstimate Analyzer::estimateSteps(const Program& program) {
+  std::vector<int64_t> call_stack;
+  size_t num_calls = 0;
+  StepEstimator estimator(call_stack, num_calls);
+  estimator.run(program);
+  return estimator.result;
+}
+
+// Data-flow analysis that tracks for every memory cell whether its value is an
+// affine function a*n+b of the input n and whether it depends on the input.
+// Values computed in loops are never affine. They depend on the input if the
+// loop counter or one of the operands does.
+class TrivialityChecker {
+ public:
+  bool run(const Program& p) {
+    cells[Program::INPUT_CELL] = {true, true, Number::ONE, Number::ZERO};
+    if (!process(p, 0, p.ops.size(), false, false)) {
+      return false;
+    }
+    return std::all_of(cells.begin(), cells.end(), [](const auto& c) {
+      return c.second.is_affine || !c.second.depends_on_input;
+    });
+  }
+
+ private:
+  struct Value {
+    bool is_affine;
+    bool depends_on_input;
+    Number a;
+    Number b;
+  };
+
+  Value get(const Operand& op) const {
+    if (op.type == Operand::Type::CONSTANT) {
+      return {true, false, Number::ZERO, op.value};
+    }
+    auto it = cells.find(op.value.asInt());
+    if (it == cells.end()) {
+      return {true, false, Number::ZERO, Number::ZERO};
+    }
+    return it->second;
+  }
+
+  static bool calcAffine(Operation::Type type, const Value& t, const Value& s,
+                         Value& result) {
+    try {
+      if (type == Operation::Type::MOV) {
+        result = s;
+      } else if (t.a == Number::ZERO && s.a == Number::ZERO) {
+        result.b = Interpreter::calc(type, t.b, s.b);
+      } else if (type == Operation::Type::ADD ||
+                 type == Operation::Type::SUB) {
+        result.a = Interpreter::calc(type, t.a, s.a);
+        result.b = Interpreter::calc(type, t.b, s.b);
+      } else if (type == Operation::Type::MUL &&
+                 (t.a == Number::ZERO || s.a == Number::ZERO)) {
+        const auto& v = (t.a == Number::ZERO) ? s : t;
+        const auto& c = (t.a == Number::ZERO) ? t.b : s.b;
+        result.a = Interpreter::calc(type, v.a, c);
+        result.b = Interpreter::calc(type, v.b, c);
+      } else {
+        return false;
+      }
+    } catch (const std::exception&) {
+      return false;
+    }
+    return result.a != Number::INF && result.b != Number::INF;
+  }
+
+  // Returns false if the program uses features not supported by the analysis.
+  bool process(const Program& p, size_t begin, size_t end, bool in_loop,
+               bool control) {
+    for (size_t i = begin; i < end; i++) {
+      const auto& op = p.ops[i];
+      if (op.type == Operation::Type::NOP || op.type == Operation::Type::DBG) {
+        continue;
+      }
+      if (ProgramUtil::hasIndirectOperand(op)) {
+        return false;
+      }
+      if (op.type == Operation::Type::LPB) {
+        if (op.source != Operand(Operand::Type::CONSTANT, 1)) {
+          return false;
+        }
+        // find the matching loop end
+        size_t j = i + 1;
+        for (int64_t depth = 1; j < end; j++) {
+          if (p.ops[j].type == Operation::Type::LPB) {
+            depth++;
+          } else if (p.ops[j].type == Operation::Type::LPE && --depth == 0) {
+            break;
+          }
+        }
+        if (j >= end) {
+          return false;
+        }
+        // the dependencies can only grow, so this reaches a fixed point
+        while (true) {
+          auto before = cells;
+          bool loop_control = control || get(op.target).depends_on_input;
+          if (!process(p, i + 1, j, true, loop_control)) {
+            return false;
+          }
+          if (std::equal(before.begin(), before.end(), cells.begin(),
+                         cells.end(), [](const auto& x, const auto& y) {
+                           return x.first == y.first &&
+                                  x.second.is_affine == y.second.is_affine &&
+                                  x.second.depends_on_input ==
+                                      y.second.depends_on_input;
+                         })) {
+            break;
+          }
+        }
+        i = j;
+        continue;
+      }
+      const auto t = get(op.target);
+      const auto s = get(op.source);
+      Value result{true, false, Number::ZERO, Number::ZERO};
+      if (op.type == Operation::Type::SEQ) {
+        result.is_affine = false;
+        result.depends_on_input = t.depends_on_input;
+      } else if (ProgramUtil::isArithmetic(op.type)) {
+        result.depends_on_input =
+            (op.type != Operation::Type::MOV && t.depends_on_input) ||
+            s.depends_on_input;
+        result.is_affine = t.is_affine && s.is_affine &&
+                           calcAffine(op.type, t, s, result);
+      } else {
+        return false;
+      }
+      if (in_loop) {
+        // the number of executions depends on the loop counter
+        result.is_affine = false;
+        result.depends_on_input |= t.depends_on_input || control;
+      }
+      cells[op.target.value.asInt()] = result;
+    }
+    return true;
+  }
+
+  std::map<int64_t, Value> cells;
+};
+
+bool Analyzer::isTrivial(const Program& program) {
+  TrivialityChecker checker;
+  return checker.run(program);
+}
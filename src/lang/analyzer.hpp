@@ -1,5 +1,8 @@
 #pragma once
 
+#include <map>
+#include <string>
+
 #include "lang/program.hpp"
 
 class SimpleLoopProgram {
@@ -9,6 +12,61 @@ class SimpleLoopProgram {
   Program body;
   Program post_loop;
   int64_t counter;
+  int64_t region_length;
+};
+
+// Asymptotic growth of a function of the program input, e.g., the value of a
+// memory cell or the number of execution steps.
+class Growth {
+ public:
+  enum class Type { CONSTANT, LOGARITHMIC, POLYNOMIAL, EXPONENTIAL, UNKNOWN };
+
+  Growth(Type type = Type::CONSTANT, int64_t degree = 0);
+
+  static Growth max(const Growth& a, const Growth& b);
+  static Growth min(const Growth& a, const Growth& b);
+  static Growth product(const Growth& a, const Growth& b);
+  static Growth power(const Growth& a, int64_t exponent);
+  static Growth exp(const Growth& a);
+  static Growth log(const Growth& a);
+  static Growth divide(const Growth& a, const Growth& b);
+  // substitute the input of function a by function b
+  static Growth compose(const Growth& a, const Growth& b);
+
+  // Approximate value of the function for the given input.
+  double evaluate(int64_t n) const;
+
+  std::string toString() const;
+
+  bool operator<(const Growth& g) const {
+    return type != g.type ? type < g.type : degree < g.degree;
+  }
+  bool operator==(const Growth& g) const {
+    return type == g.type && degree == g.degree;
+  }
+
+  Type type;
+  int64_t degree;  // only used for polynomial growth
+};
+
+// Static estimate of the number of execution steps of a program. It counts the
+// operations of the program grouped by their growth class, which is derived
+// from the nesting of loops, the updates of loop counters, the growth of the
+// values of loop counters and the steps of called programs.
+class StepEstimate {
+ public:
+  // Dominant growth class of the number of steps.
+  Growth growth;
+
+  // Number of operations per growth class.
+  std::map<Growth, int64_t> terms;
+
+  // Estimated number of steps for the given input, or -1 if unknown.
+  double evaluate(int64_t n) const;
+
+  // Check whether the estimated number of steps for the given input exceeds
+  // the maximum by a large margin. Returns false if the estimate is unknown.
+  bool exceeds(int64_t n, int64_t max_steps) const;
 };
 
 class Analyzer {
@@ -17,7 +75,11 @@ class Analyzer {
   // 1) pre-loop
   // 2) loop body
   // 3) post-loop
-  static SimpleLoopProgram extractSimpleLoop(const Program& program);
+  // Optionally, the post-loop can contain further loops and the main loop can
+  // use a region counter with a constant length.
+  static SimpleLoopProgram extractSimpleLoop(const Program& program,
+                                             bool allow_post_loops = false,
+                                             bool allow_region = false);
 
   // Static code analysis check to find out whether a program consists of a
   // loop that is executed logarithmic time complexity. This is a sufficient
@@ -28,4 +90,15 @@ class Analyzer {
   // loop that is executed exponential time complexity. This is a sufficient
   // but not a necessary check.
   static bool hasExponentialComplexity(const Program& program);
+
+  // Static code analysis to estimate the number of execution steps of a
+  // program. This is a heuristic and neither a lower nor an upper bound.
+  // Called programs are loaded from the program store.
+  static StepEstimate estimateSteps(const Program& program);
+
+  // Static data-flow check whether every memory cell of a program is either
+  // independent of the input or an affine function of it. Such programs
+  // cannot yield interesting sequences. This is a sufficient but not a
+  // necessary check.
+  static bool isTrivial(const Program& program);
 };
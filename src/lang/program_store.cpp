@@ -0,0 +1,336 @@
+#include "lang/program_store.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "lang/parser.hpp"
+#include "lang/program_util.hpp"
+#include "sys/log.hpp"
+#include "sys/setup.hpp"
+#include "sys/util.hpp"
+
+ProgramStore &ProgramStore::get() {
+  static ProgramStore store;
+  return store;
+}
+
+ProgramStore::ProgramStore()
+    : snapshot_path(Setup::getLodaHome() + "cache" + FILE_SEP +
+                    "programs_v1.bin") {}
+
+std::string ProgramStore::getProgramPath(int64_t id) {
+  if (id < 0) {
+    return ProgramUtil::getProgramPath(-id, "prg", "P");
+  } else {
+    return ProgramUtil::getProgramPath(id);
+  }
+}
+
+bool ProgramStore::getFileInfo(const std::string &path,
+                               std::filesystem::file_time_type &mtime,
+                               uintmax_t &size) {
+  std::error_code ec;
+  mtime = std::filesystem::last_write_time(path, ec);
+  if (ec) {
+    return false;
+  }
+  size = std::filesystem::file_size(path, ec);
+  return !ec;
+}
+
+std::shared_ptr<const Program> ProgramStore::getProgram(int64_t id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = programs.find(id);
+  if (it != programs.end()) {
+    return it->second.program;
+  }
+  // missing programs are not cached, because they can be added at any time
+  const auto path = getProgramPath(id);
+  Entry entry;
+  const bool has_info = getFileInfo(path, entry.mtime, entry.size);
+  if (has_info && loadFromSnapshot(id, entry)) {
+    programs[id] = entry;
+    return entry.program;
+  }
+  Parser parser;
+  entry.program = std::make_shared<const Program>(parser.parse(path));
+  if (has_info) {
+    programs[id] = entry;
+  }
+  return entry.program;
+}
+
+void ProgramStore::invalidate(int64_t id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  programs.erase(id);
+  version++;
+}
+
+void ProgramStore::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  programs.clear();
+  snapshot.reset();
+  version++;
+}
+
+bool ProgramStore::refresh(bool force) {
+  const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+  if (!force && now < next_refresh.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  next_refresh = now + REFRESH_INTERVAL.count();
+  num_refreshes++;
+  if (snapshot) {
+    snapshot->refresh();  // use replaced snapshots
+  }
+  std::filesystem::file_time_type mtime;
+  uintmax_t size;
+  bool changed = false;
+  for (auto it = programs.begin(); it != programs.end();) {
+    if (!getFileInfo(getProgramPath(it->first), mtime, size) ||
+        mtime != it->second.mtime || size != it->second.size) {
+      it = programs.erase(it);
+      changed = true;
+    } else {
+      it++;
+    }
+  }
+  if (changed) {
+    version++;
+  }
+  return changed;
+}
+
+size_t ProgramStore::size() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return programs.size();
+}
+
+// binary encoding of programs in the snapshot
+
+template <class T>
+void put(std::string &out, T v) {
+  out.append(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+bool toInt(const Number &n, int64_t &result) {
+  try {
+    result = n.asInt();
+  } catch (const std::exception &) {
+    return false;
+  }
+  return Number(result) == n;
+}
+
+bool ProgramStore::encode(const Program &p, std::string &out) {
+  out.clear();
+  put<uint64_t>(out, p.ops.size());
+  int64_t target, source;
+  for (const auto &op : p.ops) {
+    if (!toInt(op.target.value, target) || !toInt(op.source.value, source)) {
+      return false;
+    }
+    put<uint8_t>(out, static_cast<uint8_t>(op.type));
+    put<uint8_t>(out, static_cast<uint8_t>(op.target.type));
+    put<uint8_t>(out, static_cast<uint8_t>(op.source.type));
+    put<int64_t>(out, target);
+    put<int64_t>(out, source);
+    put<uint32_t>(out, op.comment.size());
+    out += op.comment;
+  }
+  put<uint64_t>(out, p.directives.size());
+  for (const auto &d : p.directives) {
+    put<uint32_t>(out, d.first.size());
+    out += d.first;
+    put<int64_t>(out, d.second);
+  }
+  return true;
+}
+
+class SnapshotReader {
+ public:
+  SnapshotReader(const char *data, size_t length)
+      : data(data), length(length), pos(0) {}
+
+  template <class T>
+  bool get(T &v) {
+    if (length - pos < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&v, data + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+
+  bool get(std::string &s) {
+    uint32_t size;
+    if (!get(size) || length - pos < size) {
+      return false;
+    }
+    s.assign(data + pos, size);
+    pos += size;
+    return true;
+  }
+
+  const char *data;
+  const size_t length;
+  size_t pos;
+};
+
+bool ProgramStore::decode(const char *data, size_t length, Program &p) {
+  SnapshotReader in(data, length);
+  uint64_t num_ops, num_directives;
+  if (!in.get(num_ops) || num_ops > length) {
+    return false;
+  }
+  p.ops.resize(num_ops);
+  uint8_t type, target_type, source_type;
+  int64_t target, source;
+  for (auto &op : p.ops) {
+    if (!in.get(type) || !in.get(target_type) || !in.get(source_type) ||
+        !in.get(target) || !in.get(source) || !in.get(op.comment) ||
+        type >= static_cast<uint8_t>(Operation::Type::__COUNT) ||
+        target_type > static_cast<uint8_t>(Operand::Type::INDIRECT) ||
+        source_type > static_cast<uint8_t>(Operand::Type::INDIRECT)) {
+      return false;
+    }
+    op.type = static_cast<Operation::Type>(type);
+    op.target = Operand(static_cast<Operand::Type>(target_type), target);
+    op.source = Operand(static_cast<Operand::Type>(source_type), source);
+  }
+  if (!in.get(num_directives) || num_directives > length) {
+    return false;
+  }
+  std::string name;
+  int64_t value;
+  for (uint64_t i = 0; i < num_directives; i++) {
+    if (!in.get(name) || !in.get(value)) {
+      return false;
+    }
+    p.directives[name] = value;
+  }
+  return in.pos == length;
+}
+
+bool ProgramStore::loadFromSnapshot(int64_t id, Entry &entry) {
+  if (!snapshot) {
+    snapshot.reset(new MappedFile(snapshot_path));
+    snapshot->refresh();
+  }
+  const char *data = snapshot->data();
+  const size_t size = snapshot->size();
+  const size_t header_size = sizeof(SNAPSHOT_TAG) + sizeof(uint64_t);
+  uint64_t num_entries;
+  if (size < header_size ||
+      std::memcmp(data, SNAPSHOT_TAG, sizeof(SNAPSHOT_TAG)) != 0) {
+    return false;
+  }
+  std::memcpy(&num_entries, data + sizeof(SNAPSHOT_TAG), sizeof(uint64_t));
+  if (num_entries > (size - header_size) / sizeof(SnapshotEntry)) {
+    return false;
+  }
+  const size_t data_pos = header_size + num_entries * sizeof(SnapshotEntry);
+  // binary search of the sorted entries
+  SnapshotEntry e;
+  size_t lo = 0, hi = num_entries;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    std::memcpy(&e, data + header_size + mid * sizeof(SnapshotEntry),
+                sizeof(SnapshotEntry));
+    if (e.id < id) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == num_entries) {
+    return false;
+  }
+  std::memcpy(&e, data + header_size + lo * sizeof(SnapshotEntry),
+              sizeof(SnapshotEntry));
+  if (e.id != id || e.mtime != entry.mtime.time_since_epoch().count() ||
+      e.size != entry.size || e.offset > size - data_pos ||
+      e.length > size - data_pos - e.offset) {
+    return false;  // missing or outdated
+  }
+  Program p;
+  if (!decode(data + data_pos + e.offset, e.length, p)) {
+    Log::get().warn("Ignoring invalid program snapshot entry for " +
+                    getProgramPath(id));
+    return false;
+  }
+  entry.program = std::make_shared<const Program>(std::move(p));
+  num_snapshot_loads++;
+  return true;
+}
+
+size_t ProgramStore::writeSnapshot(const std::vector<int64_t> &ids) {
+  std::vector<int64_t> sorted = ids;
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+  std::vector<SnapshotEntry> entries;
+  std::string data, buf;
+  for (auto id : sorted) {
+    std::shared_ptr<const Program> program;
+    try {
+      program = getProgram(id);
+    } catch (const std::exception &) {
+      continue;  // missing or invalid program
+    }
+    Entry entry;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = programs.find(id);
+      if (it == programs.end() || it->second.program != program) {
+        continue;
+      }
+      entry = it->second;
+    }
+    if (!encode(*program, buf)) {
+      continue;
+    }
+    entries.push_back({id, static_cast<int64_t>(
+                               entry.mtime.time_since_epoch().count()),
+                       static_cast<uint64_t>(entry.size), data.size(),
+                       buf.size()});
+    data += buf;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  ensureDir(snapshot_path);
+  const std::string tmp =
+      snapshot_path + ".tmp" + std::to_string(Random::get().gen() % 100000);
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    const uint64_t num_entries = entries.size();
+    out.write(SNAPSHOT_TAG, sizeof(SNAPSHOT_TAG));
+    out.write(reinterpret_cast<const char *>(&num_entries),
+              sizeof(num_entries));
+    out.write(reinterpret_cast<const char *>(entries.data()),
+              entries.size() * sizeof(SnapshotEntry));
+    out.write(data.data(), data.size());
+    if (!out) {
+      Log::get().warn("Cannot write program snapshot: " + snapshot_path);
+      std::remove(tmp.c_str());
+      return 0;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, snapshot_path, ec);
+  if (ec) {
+    Log::get().warn("Cannot write program snapshot: " + snapshot_path);
+    std::remove(tmp.c_str());
+    return 0;
+  }
+  snapshot.reset();
+  return entries.size();
+}
+
+void ProgramStore::setSnapshotPath(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mutex);
+  snapshot_path = path;
+  snapshot.reset();
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "lang/program.hpp"
+#include "sys/file.hpp"
+
+// Process-wide store of parsed programs from the programs directory. Programs
+// are keyed by their ID, where negative IDs refer to "prg" programs. The store
+// returns immutable programs, so that every program file is parsed at most
+// once per process. Entries must be invalidated when a file is (re-)written.
+// Files written by other processes are detected by refreshing the store, which
+// compares the modification times and sizes of the files.
+//
+// Programs can also be loaded from a memory-mapped binary snapshot, which is
+// shared by all processes on the host. It contains the operations of the
+// called programs in binary form, so that they are not parsed again by every
+// miner process. Snapshot entries are used only if the modification time and
+// size of the program file are unchanged.
+class ProgramStore {
+ public:
+  // magic number: minimum time between two checks of the program files
+  static constexpr std::chrono::seconds REFRESH_INTERVAL{60};
+
+  static constexpr char SNAPSHOT_TAG[8] = {'L', 'O', 'D', 'A',
+                                           'P', 'R', 'G', '1'};
+
+  static ProgramStore &get();
+
+  static std::string getProgramPath(int64_t id);
+
+  // Throws an exception if the program cannot be loaded.
+  std::shared_ptr<const Program> getProgram(int64_t id);
+
+  void invalidate(int64_t id);
+
+  void clear();
+
+  // Remove programs whose files were changed on disk. Unless forced, the files
+  // are checked at most once per refresh interval. Returns true if programs
+  // were removed.
+  bool refresh(bool force = false);
+
+  size_t size();
+
+  // Write a snapshot of the given programs, which replaces the current one.
+  // Programs that cannot be loaded or have operands beyond 64 bits are
+  // skipped. Returns the number of written programs.
+  size_t writeSnapshot(const std::vector<int64_t> &ids);
+
+  void setSnapshotPath(const std::string &path);
+
+  // number of programs loaded from the snapshot
+  size_t getNumSnapshotLoads() const { return num_snapshot_loads; }
+
+  // The version is incremented whenever entries are invalidated.
+  size_t getVersion() const { return version; }
+
+  // Number of checks of the program files. Missing programs can be added
+  // by other processes at any time, so they should be looked up again after
+  // every check.
+  size_t getNumRefreshes() const { return num_refreshes; }
+
+ private:
+  struct Entry {
+    std::shared_ptr<const Program> program;
+    std::filesystem::file_time_type mtime;
+    uintmax_t size;
+  };
+
+  struct SnapshotEntry {
+    int64_t id;
+    int64_t mtime;
+    uint64_t size;
+    uint64_t offset;  // relative to the start of the program data
+    uint64_t length;
+  };
+
+  ProgramStore();
+
+  static bool getFileInfo(const std::string &path,
+                          std::filesystem::file_time_type &mtime,
+                          uintmax_t &size);
+
+  static bool encode(const Program &p, std::string &out);
+
+  static bool decode(const char *data, size_t length, Program &p);
+
+  bool loadFromSnapshot(int64_t id, Entry &entry);
+
+  std::mutex mutex;
+  std::atomic<size_t> version{0};
+  std::atomic<size_t> num_refreshes{0};
+  std::atomic<int64_t> next_refresh{0};  // in seconds of the steady clock
+  std::atomic<size_t> num_snapshot_loads{0};
+  std::unordered_map<int64_t, Entry> programs;
+  std::string snapshot_path;
+  std::unique_ptr<MappedFile> snapshot;
+};
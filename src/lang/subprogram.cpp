@@ -3,7 +3,7 @@
 #include <stdexcept>
 
 #include "eval/evaluator_par.hpp"
-#include "lang/parser.hpp"
+#include "lang/program_store.hpp"
 #include "lang/program_util.hpp"
 
 size_t Subprogram::replaceAllExact(Program &main, const Program &search,
@@ -110,16 +110,13 @@ void updateOperand(Operand &op, int64_t start, int64_t shared_region_length,
 
 bool prepareEmbedding(int64_t id, Program &sub, Operation::Type embeddingType) {
   // load and check program to be embedded
-  std::string path;
   if (embeddingType == Operation::Type::SEQ) {
-    path = ProgramUtil::getProgramPath(id);
+    sub = *ProgramStore::get().getProgram(id);
   } else if (embeddingType == Operation::Type::PRG) {
-    path = ProgramUtil::getProgramPath(id, "prg", "P");
+    sub = *ProgramStore::get().getProgram(-id);
   } else {
     throw std::runtime_error("Unsupported embedding type");
   }
-  Parser parser;
-  sub = parser.parse(path);
   if (ProgramUtil::hasIndirectOperand(sub)) {
     return false;
   }
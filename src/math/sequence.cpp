@@ -133,17 +133,3 @@ std::size_t SequenceHasher::operator()(const Sequence &s) const {
   }
   return seed;
 }
-
-void SequenceToIdsMap::remove(Sequence seq, size_t id) {
-  auto ids = find(seq);
-  if (ids != end()) {
-    auto it = ids->second.begin();
-    while (it != ids->second.end()) {
-      if (*it == id) {
-        it = ids->second.erase(it);
-      } else {
-        ++it;
-      }
-    }
-  }
-}
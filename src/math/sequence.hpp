@@ -1,6 +1,5 @@
 #pragma once
 
-#include <unordered_map>
 #include <vector>
 
 #include "math/number.hpp"
@@ -35,9 +34,3 @@ class Sequence : public std::vector<Number> {
 struct SequenceHasher {
   std::size_t operator()(const Sequence &s) const;
 };
-
-class SequenceToIdsMap
-    : public std::unordered_map<Sequence, std::vector<size_t>, SequenceHasher> {
- public:
-  void remove(Sequence seq, size_t id);
-};
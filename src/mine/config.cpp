@@ -124,10 +124,13 @@ Miner::Config ConfigLoader::load(const Settings &settings) {
 
       // load matcher configs
       bool backoff = getJBool(m, "backoff", true);
+      double filter_rate =
+          getJDouble(m, "filterRate", Matcher::DEFAULT_FILTER_RATE);
       auto matchers = m["matchers"];
       for (int j = 0; j < matchers.size(); j++) {
         Matcher::Config mc;
         mc.backoff = backoff;
+        mc.filter_rate = filter_rate;
         mc.type = matchers[j].as_string();
         config.matchers.push_back(mc);
       }
@@ -172,3 +172,18 @@ bool Extender::digit(Program &p, int64_t num_digits, int64_t offset) {
               Operand::Type::CONSTANT, num_digits);
   return true;
 }
+
+bool Extender::shift(Program &p, int64_t shift) {
+  if (shift > 0) {
+    p.ops.insert(p.ops.begin(),
+                 Operation(Operation::Type::ADD,
+                           Operand(Operand::Type::DIRECT, Program::INPUT_CELL),
+                           Operand(Operand::Type::CONSTANT, shift)));
+  } else if (shift < 0) {
+    p.ops.insert(p.ops.begin(),
+                 Operation(Operation::Type::SUB,
+                           Operand(Operand::Type::DIRECT, Program::INPUT_CELL),
+                           Operand(Operand::Type::CONSTANT, -shift)));
+  }
+  return true;
+}
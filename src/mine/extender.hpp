@@ -19,4 +19,8 @@ class Extender {
   static bool delta_it(Program &p, int64_t delta);
 
   static bool digit(Program &p, int64_t num_digits, int64_t offset);
+
+  // Shift the argument of a program, i.e., the extended program computes
+  // the term of the original program at index n+shift.
+  static bool shift(Program &p, int64_t shift);
 };
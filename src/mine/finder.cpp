@@ -1,9 +1,14 @@
 #include "mine/finder.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <set>
 #include <sstream>
+#include <thread>
 
 #include "lang/analyzer.hpp"
 #include "lang/constants.hpp"
@@ -21,26 +26,85 @@
 Finder::Finder(const Settings &settings, Evaluator &evaluator)
     : settings(settings),
       evaluator(evaluator),
+      thread_settings(settings),
       optimizer(settings),
       minimizer(settings),
-      num_find_attempts(0),
+      output_cache_key(0),
+      num_output_lookups(0),
+      num_output_hits(0),
+      step_estimate_stats{0, 0, std::chrono::nanoseconds(0)},
       scheduler(1800)  // 30 minutes
 {
+  if (settings.use_output_cache) {
+    output_cache.assign(OUTPUT_CACHE_SIZE, 0);
+  }
+  thread_settings.use_term_store = false;
+  thread_settings.num_eval_threads = 1;
+  if (settings.num_find_threads > 1) {
+    const int64_t num_threads =
+        std::min<int64_t>(settings.num_find_threads, 64);  // magic number
+    for (int64_t t = 0; t < num_threads; t++) {
+      thread_evaluators.emplace_back(new Evaluator(thread_settings));
+    }
+  }
+  createMatchers();
+}
+
+void Finder::createMatchers() {
   auto config = ConfigLoader::load(settings);
   if (config.matchers.empty()) {
     Log::get().error("No matchers defined", true);
   }
-
-  // create matchers
   matchers.clear();
+  matcher_configs.clear();
   for (auto m : config.matchers) {
     try {
       auto matcher = Matcher::Factory::create(m);
       matchers.emplace_back(std::move(matcher));
+      matcher_configs.push_back(m);
     } catch (const std::exception &) {
       Log::get().warn("Ignoring error while loading " + m.type + " matcher");
     }
   }
+  tmp_context = ReductionContext();
+  for (const auto &matcher : matchers) {
+    matcher->configure(tmp_context);
+  }
+  thread_contexts.assign(thread_evaluators.size(), tmp_context);
+}
+
+// Run tasks in parallel using the given number of threads, including the
+// calling thread. Tasks are handed out in ascending order to the next idle
+// thread. The first exception in task order is rethrown after all threads
+// finished.
+template <class F>
+void runParallel(size_t num_threads, size_t num_tasks, F task) {
+  num_threads = std::min(num_threads, num_tasks);
+  std::atomic<size_t> next_task(0);
+  std::vector<std::exception_ptr> errors(num_tasks);
+  auto worker = [&](size_t t) {
+    size_t i;
+    while ((i = next_task.fetch_add(1)) < num_tasks) {
+      try {
+        task(t, i);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < num_threads; t++) {
+    threads.emplace_back(worker, t);
+  }
+  worker(0);
+  for (auto &t : threads) {
+    t.join();
+  }
+  for (auto &e : errors) {
+    if (e) {
+      std::rethrow_exception(e);
+    }
+  }
 }
 
 void Finder::insert(const Sequence &norm_seq, size_t id) {
@@ -49,6 +113,264 @@ void Finder::insert(const Sequence &norm_seq, size_t id) {
   }
 }
 
+void writeUInt(std::ostream &out, uint64_t value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+uint64_t readUInt(const MappedFile &file, size_t &pos) {
+  uint64_t value;
+  if (pos + sizeof(value) > file.size()) {
+    throw std::runtime_error("unexpected end of file");
+  }
+  std::memcpy(&value, file.data() + pos, sizeof(value));
+  pos += sizeof(value);
+  return value;
+}
+
+uint64_t Finder::getMatchersKey() const {
+  uint64_t key = FingerprintIndex::combine(0, PREFIX_LENGTH);
+  for (const auto &config : matcher_configs) {
+    for (char c : config.type) {
+      key = FingerprintIndex::combine(key, static_cast<uint8_t>(c));
+    }
+    uint64_t rate_bits;
+    std::memcpy(&rate_bits, &config.filter_rate, sizeof(rate_bits));
+    key = FingerprintIndex::combine(key, config.backoff);
+    key = FingerprintIndex::combine(key, rate_bits);
+  }
+  return key;
+}
+
+void Finder::saveIndexes(const std::string &path, uint64_t key) const {
+  const std::string tmp =
+      path + ".tmp" + std::to_string(Random::get().gen() % 100000);
+  ensureDir(tmp);
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    out.write(INDEX_TAG, sizeof(INDEX_TAG));
+    writeUInt(out, key);
+    writeUInt(out, matchers.size());
+    for (const auto &matcher : matchers) {
+      std::string name = matcher->getName();
+      name.resize(INDEX_NAME_LENGTH, '\0');
+      out.write(name.data(), name.size());
+      matcher->writeIndex(out);
+    }
+    if (!out) {
+      Log::get().warn("Cannot write matcher indexes to " + tmp);
+      std::filesystem::remove(tmp);
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, path, ec);
+  if (ec) {
+    Log::get().warn("Cannot write matcher indexes to " + path);
+    std::filesystem::remove(tmp, ec);
+  }
+}
+
+bool Finder::loadIndexes(const std::string &path, uint64_t key) {
+  auto file = std::make_shared<MappedFile>(path);
+  file->refresh();
+  size_t pos = sizeof(INDEX_TAG);
+  if (file->size() < pos ||
+      std::memcmp(file->data(), INDEX_TAG, sizeof(INDEX_TAG)) != 0) {
+    return false;
+  }
+  try {
+    if (readUInt(*file, pos) != key || readUInt(*file, pos) != matchers.size()) {
+      return false;
+    }
+    for (auto &matcher : matchers) {
+      std::string name = matcher->getName();
+      name.resize(INDEX_NAME_LENGTH, '\0');
+      if (pos + INDEX_NAME_LENGTH > file->size() ||
+          name != std::string(file->data() + pos, INDEX_NAME_LENGTH)) {
+        throw std::runtime_error("unexpected matcher");
+      }
+      pos += INDEX_NAME_LENGTH;
+      matcher->mapIndex(file, pos);
+    }
+  } catch (const std::exception &e) {
+    Log::get().warn("Ignoring invalid matcher indexes in " + path + ": " +
+                    e.what());
+    createMatchers();
+    return false;
+  }
+  return true;
+}
+
+void Finder::loadOutputCache(const std::string &path, uint64_t key) {
+  output_cache_path = path;
+  output_cache_key = key;
+  if (output_cache.empty()) {
+    return;
+  }
+  MappedFile file(path);
+  file.refresh();
+  size_t pos = sizeof(OUTPUT_CACHE_TAG);
+  const size_t size = output_cache.size() * sizeof(uint64_t);
+  if (file.size() != pos + 2 * sizeof(uint64_t) + size ||
+      std::memcmp(file.data(), OUTPUT_CACHE_TAG, pos) != 0 ||
+      readUInt(file, pos) != key ||
+      readUInt(file, pos) != output_cache.size()) {
+    return;  // missing or outdated
+  }
+  std::memcpy(output_cache.data(), file.data() + pos, size);
+  Log::get().debug("Loaded output cache from " + path);
+}
+
+void Finder::saveOutputCache() const {
+  if (output_cache.empty() || output_cache_path.empty()) {
+    return;
+  }
+  const std::string tmp = output_cache_path + ".tmp" +
+                          std::to_string(Random::get().gen() % 100000);
+  ensureDir(tmp);
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    out.write(OUTPUT_CACHE_TAG, sizeof(OUTPUT_CACHE_TAG));
+    writeUInt(out, output_cache_key);
+    writeUInt(out, output_cache.size());
+    out.write(reinterpret_cast<const char *>(output_cache.data()),
+              output_cache.size() * sizeof(uint64_t));
+    if (!out) {
+      Log::get().warn("Cannot write output cache to " + tmp);
+      std::filesystem::remove(tmp);
+      return;
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, output_cache_path, ec);
+  if (ec) {
+    Log::get().warn("Cannot write output cache to " + output_cache_path);
+    std::filesystem::remove(tmp, ec);
+  }
+}
+
+std::pair<size_t, size_t> Finder::getOutputCacheStats(bool reset) {
+  std::pair<size_t, size_t> result(num_output_lookups, num_output_hits);
+  if (reset) {
+    num_output_lookups = 0;
+    num_output_hits = 0;
+  }
+  return result;
+}
+
+Finder::StepEstimateStats Finder::getStepEstimateStats(bool reset) {
+  auto result = step_estimate_stats;
+  if (reset) {
+    step_estimate_stats = {0, 0, std::chrono::nanoseconds(0)};
+  }
+  return result;
+}
+
+bool Finder::exceedsStepEstimate(const Program &p) {
+  // the estimate can only reject programs with an exponential number of
+  // steps, which requires loops with exponentially growing counters or calls
+  size_t num_loops = 0;
+  bool has_exp = false, has_call = false;
+  for (const auto &op : p.ops) {
+    switch (op.type) {
+      case Operation::Type::LPB:
+        num_loops++;
+        break;
+      case Operation::Type::POW:
+      case Operation::Type::BIN:
+        has_exp = true;
+        break;
+      case Operation::Type::SEQ:
+      case Operation::Type::PRG:
+        has_call = true;
+        break;
+      default:
+        break;
+    }
+  }
+  if (!has_call && num_loops < 2 && (num_loops == 0 || !has_exp)) {
+    return false;
+  }
+  const auto start_time = std::chrono::steady_clock::now();
+  const int64_t last_input = OeisProgram::getNumRequiredTerms(p) - 1 +
+                             ProgramUtil::getOffset(p);
+  const bool exceeds =
+      Analyzer::estimateSteps(p).exceeds(last_input, settings.max_cycles);
+  step_estimate_stats.num_estimates++;
+  step_estimate_stats.num_skipped += exceeds;
+  step_estimate_stats.time += std::chrono::steady_clock::now() - start_time;
+  return exceeds;
+}
+
+void Finder::initPrefixIndex(size_t num_sequences) {
+  prefix_filters.clear();
+  if (static_cast<int64_t>(settings.num_terms) <= PREFIX_LENGTH) {
+    return;
+  }
+  prefix_filters.resize(matchers.size());
+  for (auto &filter : prefix_filters) {
+    filter.init(num_sequences, Matcher::DEFAULT_FILTER_RATE);
+  }
+}
+
+void Finder::insertPrefix(const Sequence &norm_seq) {
+  const auto prefix = norm_seq.subsequence(0, PREFIX_LENGTH);
+  uint64_t key;
+  for (size_t i = 0; i < prefix_filters.size(); i++) {
+    if (prefix.size() == PREFIX_LENGTH &&
+        matchers[i]->getPrefixKey(prefix, key)) {
+      prefix_filters[i].insert(key);
+    } else {
+      // disable the filter, because it must contain all sequences
+      prefix_filters[i].init(0, 0);
+    }
+  }
+}
+
+bool Finder::usePrefixIndex() const {
+  // matchers without prefix keys have disabled filters and are not filtered
+  return std::any_of(prefix_filters.begin(), prefix_filters.end(),
+                     [](const BloomFilter &f) { return f.isEnabled(); });
+}
+
+bool Finder::hasPrefixMatch(const Sequence &prefix,
+                            std::vector<bool> &prefix_matches) const {
+  uint64_t key;
+  bool result = false;
+  prefix_matches.assign(matchers.size(), true);
+  for (size_t i = 0; i < prefix_filters.size(); i++) {
+    if (prefix_filters[i].isEnabled() &&
+        matchers[i]->getPrefixKey(prefix, key) &&
+        !prefix_filters[i].contains(key)) {
+      prefix_matches[i] = false;
+    }
+    result = result || prefix_matches[i];
+  }
+  return result;
+}
+
+bool Finder::isProcessedOutput(const Sequence &seq) {
+  if (output_cache.empty()) {
+    return false;
+  }
+  // zero marks empty entries
+  const uint64_t fp = std::max<uint64_t>(FingerprintIndex::fingerprint(seq), 1);
+  num_output_lookups++;
+  if (output_cache[fp & (output_cache.size() - 1)] == fp) {
+    num_output_hits++;
+    return true;
+  }
+  return false;
+}
+
+void Finder::addProcessedOutput(const Sequence &seq) {
+  if (output_cache.empty()) {
+    return;
+  }
+  const uint64_t fp = std::max<uint64_t>(FingerprintIndex::fingerprint(seq), 1);
+  output_cache[fp & (output_cache.size() - 1)] = fp;
+}
+
 void Finder::remove(const Sequence &norm_seq, size_t id) {
   for (auto &matcher : matchers) {
     matcher->remove(norm_seq, id);
@@ -58,14 +380,6 @@ void Finder::remove(const Sequence &norm_seq, size_t id) {
 Matcher::seq_programs_t Finder::findSequence(
     const Program &p, Sequence &norm_seq,
     const std::vector<OeisSequence> &sequences) {
-  // update memory usage info
-  if (num_find_attempts++ % 1000 == 0) {
-    bool has_memory = Setup::hasMemory();
-    for (const auto &matcher : matchers) {
-      matcher->has_memory = has_memory;
-    }
-  }
-
   // determine largest memory cell to check
   int64_t max_index = 20;  // magic number
   int64_t largest_used_cell;
@@ -76,57 +390,227 @@ Matcher::seq_programs_t Finder::findSequence(
     max_index = largest_used_cell;
   }
 
-  // interpret program
-  tmp_seqs.resize(std::max<size_t>(2, max_index + 1));
+  // skip programs that likely exceed the maximum number of cycles for the
+  // required number of terms, because their matches would be rejected anyway
   Matcher::seq_programs_t result;
+  norm_seq.clear();
+  if (exceedsStepEstimate(p)) {
+    return result;
+  }
+
+  // interpret program
+  const size_t num_cells = std::max<size_t>(2, max_index + 1);
+  tmp_seqs.resize(num_cells);
+  tmp_skip_cells.assign(num_cells, false);
+  tmp_prefix_matches.resize(num_cells);
+  for (auto &m : tmp_prefix_matches) {
+    m.clear();
+  }
   try {
-    evaluator.eval(p, tmp_seqs);
+    if (usePrefixIndex()) {
+      // evaluate the first terms and skip the cells that cannot be matched
+      evaluator.eval(p, tmp_seqs, PREFIX_LENGTH);
+      bool has_match = false;
+      for (size_t i = 0; i < num_cells; i++) {
+        tmp_skip_cells[i] =
+            !hasPrefixMatch(tmp_seqs[i], tmp_prefix_matches[i]);
+        has_match = has_match || !tmp_skip_cells[i];
+      }
+      if (!has_match) {
+        return result;
+      }
+      evaluator.eval(p, tmp_seqs, settings.num_terms, PREFIX_LENGTH);
+    } else {
+      evaluator.eval(p, tmp_seqs);
+    }
     norm_seq = tmp_seqs[1];
   } catch (const std::exception &) {
     // evaluation error
     return result;
   }
+  for (size_t i = 0; i < num_cells; i++) {
+    tmp_skip_cells[i] = tmp_skip_cells[i] || isProcessedOutput(tmp_seqs[i]);
+  }
+  if (thread_evaluators.size() > 1) {
+    findAllParallel(p, sequences, result);
+    return result;
+  }
   Program p2 = p;
   p2.push_back(Operation::Type::MOV, Operand::Type::DIRECT,
                Program::OUTPUT_CELL, Operand::Type::DIRECT, 0);
-  for (size_t i = 0; i < tmp_seqs.size(); i++) {
+  for (size_t i = 0; i < num_cells; i++) {
+    if (tmp_skip_cells[i]) {
+      continue;
+    }
     if (i == Program::OUTPUT_CELL) {
-      findAll(p, tmp_seqs[i], sequences, result);
+      findAll(p, tmp_seqs[i], tmp_prefix_matches[i], sequences, result);
     } else {
       p2.ops.back().source.value = i;
-      findAll(p2, tmp_seqs[i], sequences, result);
+      findAll(p2, tmp_seqs[i], tmp_prefix_matches[i], sequences, result);
     }
   }
   return result;
 }
 
+bool Finder::collectMatches(const Sequence &norm_seq, ReductionContext &ctx,
+                            const std::vector<bool> &prefix_matches,
+                            std::vector<Candidate> &candidates) const {
+  Matcher::matches_t matches;
+  bool complete = true;
+  ctx.init(norm_seq);
+  for (size_t i = 0; i < matchers.size(); i++) {
+    if (!prefix_matches.empty() && !prefix_matches[i]) {
+      continue;
+    }
+    matches.clear();
+    complete = matchers[i]->match(norm_seq, ctx, matches) && complete;
+    for (auto &m : matches) {
+      candidates.push_back({i, std::move(m)});
+    }
+  }
+  return complete;
+}
+
+bool Finder::extendCandidate(const Program &p, const Candidate &c,
+                             std::pair<size_t, Program> &last,
+                             std::pair<size_t, Program> &result) const {
+  result.first = c.match.id;
+  result.second = p;
+  if (!matchers[c.matcher]->extendProgram(result.second, c.match)) {
+    return false;
+  }
+  if (result == last) {
+    // Log::get().warn("Ignoring duplicate match for " + s.id_str());
+    return false;
+  }
+  last = result;
+  return true;
+}
+
 void Finder::findAll(const Program &p, const Sequence &norm_seq,
+                     const std::vector<bool> &prefix_matches,
                      const std::vector<OeisSequence> &sequences,
                      Matcher::seq_programs_t &result) {
   // collect possible matches
-  std::pair<size_t, Program> last(0, Program());
-  for (size_t i = 0; i < matchers.size(); i++) {
-    tmp_result.clear();
-    matchers[i]->match(p, norm_seq, tmp_result);
-
-    // validate the found matches
-    for (auto t : tmp_result) {
-      auto &s = sequences.at(t.first);
-      if (t == last) {
-        // Log::get().warn("Ignoring duplicate match for " + s.id_str());
+  tmp_candidates.clear();
+  // outputs are cached only if no matcher backed off, because the back off
+  // is temporary
+  if (collectMatches(norm_seq, tmp_context, prefix_matches, tmp_candidates) &&
+      tmp_candidates.empty()) {
+    addProcessedOutput(norm_seq);
+  }
+
+  // validate the found matches
+  std::pair<size_t, Program> last(0, Program()), t;
+  size_t backoff_matcher = matchers.size();
+  for (const auto &c : tmp_candidates) {
+    if (c.matcher == backoff_matcher) {
+      continue;
+    }
+    auto &s = sequences.at(c.match.id);
+    auto expected_seq = s.getTerms(s.existingNumTerms());
+    // the matcher index only contains fingerprints of the sequences
+    if (!matchers[c.matcher]->verify(
+            norm_seq, expected_seq.subsequence(0, settings.num_terms))) {
+      continue;
+    }
+    // extend the program only for verified matches
+    if (!extendCandidate(p, c, last, t)) {
+      continue;
+    }
+    // avoid too many matches for the same sequence
+    if (matchers[c.matcher]->hasBackoff() && Matcher::randomBackoff()) {
+      backoff_matcher = c.matcher;
+    }
+    auto num_required = OeisProgram::getNumRequiredTerms(t.second);
+    auto res = evaluator.check(t.second, expected_seq, num_required, t.first);
+    if (res.first == status_t::ERROR) {
+      notifyInvalidMatch(t.first);
+      // Log::get().warn( "Ignoring invalid match for " + s.id_str() );
+    } else {
+      result.push_back(std::move(t));
+      // Log::get().info( "Found potential match for " + s.id_str() );
+    }
+  }
+}
+
+void Finder::findAllParallel(const Program &p,
+                             const std::vector<OeisSequence> &sequences,
+                             Matcher::seq_programs_t &result) {
+  const size_t num_threads = thread_evaluators.size();
+  const size_t num_cells = tmp_seqs.size();
+
+  // match the sequences of all memory cells in parallel
+  std::vector<std::vector<Candidate>> cell_candidates(num_cells);
+  std::vector<uint8_t> cell_complete(num_cells, false);
+  runParallel(num_threads, num_cells, [&](size_t t, size_t i) {
+    if (!tmp_skip_cells[i]) {
+      cell_complete[i] =
+          collectMatches(tmp_seqs[i], thread_contexts[t],
+                         tmp_prefix_matches[i], cell_candidates[i]);
+    }
+  });
+
+  for (size_t i = 0; i < num_cells; i++) {
+    if (cell_complete[i] && cell_candidates[i].empty()) {
+      addProcessedOutput(tmp_seqs[i]);
+    }
+  }
+
+  // fetch the expected terms sequentially, because the sequences load them
+  // lazily; the matches remain in the order of the sequential search
+  std::vector<std::pair<size_t, Program>> matches;
+  std::vector<Sequence> expected;
+  std::pair<size_t, Program> t;
+  for (size_t i = 0; i < num_cells; i++) {
+    Program base;
+    std::pair<size_t, Program> last(0, Program());
+    size_t backoff_matcher = matchers.size();
+    for (const auto &c : cell_candidates[i]) {
+      if (c.matcher == backoff_matcher) {
         continue;
       }
-      last = t;
+      auto &s = sequences.at(c.match.id);
       auto expected_seq = s.getTerms(s.existingNumTerms());
-      auto num_required = OeisProgram::getNumRequiredTerms(t.second);
-      auto res = evaluator.check(t.second, expected_seq, num_required, t.first);
-      if (res.first == status_t::ERROR) {
-        notifyInvalidMatch(t.first);
-        // Log::get().warn( "Ignoring invalid match for " + s.id_str() );
-      } else {
-        result.push_back(t);
-        // Log::get().info( "Found potential match for " + s.id_str() );
+      if (!matchers[c.matcher]->verify(
+              tmp_seqs[i], expected_seq.subsequence(0, settings.num_terms))) {
+        continue;
+      }
+      // extend the program only for verified matches
+      if (base.ops.empty()) {
+        base = p;
+        if (i != Program::OUTPUT_CELL) {
+          base.push_back(Operation::Type::MOV, Operand::Type::DIRECT,
+                         Program::OUTPUT_CELL, Operand::Type::DIRECT, i);
+        }
       }
+      if (extendCandidate(base, c, last, t)) {
+        matches.emplace_back(std::move(t));
+        expected.emplace_back(std::move(expected_seq));
+        // avoid too many matches for the same sequence
+        if (matchers[c.matcher]->hasBackoff() && Matcher::randomBackoff()) {
+          backoff_matcher = c.matcher;
+        }
+      }
+    }
+  }
+
+  // check the matches in parallel
+  std::vector<status_t> status(matches.size());
+  runParallel(num_threads, matches.size(), [&](size_t t, size_t j) {
+    auto &m = matches[j];
+    auto num_required = OeisProgram::getNumRequiredTerms(m.second);
+    status[j] = thread_evaluators[t]
+                    ->check(m.second, expected[j], num_required, m.first)
+                    .first;
+  });
+
+  // merge the results in order
+  for (size_t j = 0; j < matches.size(); j++) {
+    if (status[j] == status_t::ERROR) {
+      notifyInvalidMatch(matches[j].first);
+    } else {
+      result.push_back(std::move(matches[j]));
     }
   }
 }
@@ -446,4 +930,37 @@ void Finder::logSummary(size_t loaded_count) {
         << matchers[i]->getCompationRatio() << "%";
   }
   Log::get().debug(buf.str());
+  buf.str("");
+  buf << "Matcher index sizes: ";
+  for (size_t i = 0; i < matchers.size(); i++) {
+    if (i > 0) buf << ", ";
+    buf << matchers[i]->getName() << ": " << std::fixed << std::setprecision(1)
+        << (matchers[i]->getIndexSize() / (1024.0 * 1024.0)) << " MB";
+  }
+  Log::get().debug(buf.str());
+  buf.str("");
+  buf << "Matcher filter sizes: ";
+  for (size_t i = 0; i < matchers.size(); i++) {
+    if (i > 0) buf << ", ";
+    auto stats = matchers[i]->getFilterStats();
+    buf << matchers[i]->getName() << ": " << std::fixed << std::setprecision(1)
+        << (stats.size_in_bytes / (1024.0 * 1024.0)) << " MB ("
+        << std::setprecision(2) << (100.0 * stats.target_rate)
+        << "% false positives)";
+  }
+  Log::get().debug(buf.str());
+  buf.str("");
+  if (usePrefixIndex()) {
+    buf << "Staged matching active using prefix filters of ";
+    bool first = true;
+    for (size_t i = 0; i < prefix_filters.size(); i++) {
+      if (prefix_filters[i].isEnabled()) {
+        buf << (first ? "" : ", ") << matchers[i]->getName();
+        first = false;
+      }
+    }
+  } else {
+    buf << "Staged matching inactive";
+  }
+  Log::get().info(buf.str());
 }
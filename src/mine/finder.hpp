@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 
 #include "eval/evaluator.hpp"
@@ -18,6 +19,49 @@ class Finder {
 
   void remove(const Sequence &norm_seq, size_t id);
 
+  // Initialize the index of sequence prefixes for the given number of
+  // sequences. It is used to skip the evaluation of further terms of programs
+  // whose first terms cannot be matched. Only matchers that support prefix
+  // keys are filtered.
+  void initPrefixIndex(size_t num_sequences);
+
+  void insertPrefix(const Sequence &norm_seq);
+
+  // Key of the matchers and their settings, i.e., names, back off and filter
+  // rates, and the prefix length. It needs to be part of the keys of the
+  // saved indexes and output caches, which depend on the matchers.
+  uint64_t getMatchersKey() const;
+
+  // Save the matcher indexes to a binary file. The key identifies the inserted
+  // sequences and the matcher settings.
+  void saveIndexes(const std::string &path, uint64_t key) const;
+
+  // Use the matcher indexes from a memory mapping of a binary file, which is
+  // shared by all processes on the host. Returns false if the file does not
+  // exist or was created for another key.
+  bool loadIndexes(const std::string &path, uint64_t key);
+
+  // Load the cache of processed output sequences from a binary file, which
+  // is also used for saving it. The key identifies the inserted sequences.
+  void loadOutputCache(const std::string &path, uint64_t key);
+
+  void saveOutputCache() const;
+
+  // number of lookups and hits in the output cache since the last reset
+  std::pair<size_t, size_t> getOutputCacheStats(bool reset);
+
+  // statistics of the step estimates of programs since the last reset
+  class StepEstimateStats {
+   public:
+    size_t num_estimates;
+    size_t num_skipped;  // programs that exceed the maximum number of steps
+    std::chrono::nanoseconds time;
+  };
+
+  StepEstimateStats getStepEstimateStats(bool reset);
+
+  // Sets norm_seq to the evaluated output sequence, or clears it if the
+  // program was skipped or not fully evaluated.
   Matcher::seq_programs_t findSequence(
       const Program &p, Sequence &norm_seq,
       const std::vector<OeisSequence> &sequences);
@@ -42,21 +86,93 @@ class Finder {
  private:
   static constexpr double THRESHOLD_BETTER = 1.05;
   static constexpr double THRESHOLD_FASTER = 1.1;
+  static constexpr char INDEX_TAG[8] = {'L', 'O', 'D', 'A', 'I', 'D', 'X', '1'};
+  static constexpr size_t INDEX_NAME_LENGTH = 16;
+  static constexpr char OUTPUT_CACHE_TAG[8] = {'L', 'O', 'D', 'A',
+                                               'O', 'U', 'T', '1'};
+  static constexpr size_t OUTPUT_CACHE_SIZE = 1 << 18;
+  static constexpr int64_t PREFIX_LENGTH = 4;
+
+  void createMatchers();
+
+  // Check whether a program likely exceeds the maximum number of cycles for
+  // the required number of terms.
+  bool exceedsStepEstimate(const Program &p);
+
+  // potential match of a memory cell that still needs to be verified
+  struct Candidate {
+    size_t matcher;
+    Matcher::Match match;
+  };
+
+  // Collect the candidates of the matchers that are not excluded by the
+  // prefix filters. An empty mask enables all matchers. Returns false if a
+  // matcher backed off, i.e., the candidates may be incomplete.
+  bool collectMatches(const Sequence &norm_seq, ReductionContext &ctx,
+                      const std::vector<bool> &prefix_matches,
+                      std::vector<Candidate> &candidates) const;
+
+  // Extend a program for a verified candidate. Returns false if it cannot be
+  // extended or is a duplicate of the last extended program.
+  bool extendCandidate(const Program &p, const Candidate &c,
+                       std::pair<size_t, Program> &last,
+                       std::pair<size_t, Program> &result) const;
 
   void findAll(const Program &p, const Sequence &norm_seq,
+               const std::vector<bool> &prefix_matches,
                const std::vector<OeisSequence> &sequences,
                Matcher::seq_programs_t &result);
 
+  void findAllParallel(const Program &p,
+                       const std::vector<OeisSequence> &sequences,
+                       Matcher::seq_programs_t &result);
+
+  // Determine the matchers that could match a sequence with the given prefix.
+  // Matchers without prefix filters can always match. Returns false if none
+  // of the matchers can match.
+  bool hasPrefixMatch(const Sequence &prefix,
+                      std::vector<bool> &prefix_matches) const;
+
+  bool usePrefixIndex() const;
+
+  // Check whether an output sequence was processed recently without any
+  // possible matches.
+  bool isProcessedOutput(const Sequence &seq);
+
+  // Add an output sequence without possible matches to the cache. Outputs
+  // with matches are not cached, because their results depend on the
+  // program.
+  void addProcessedOutput(const Sequence &seq);
+
   void notifyInvalidMatch(size_t id);
 
   void notifyUnfoldOrMinimizeProblem(const Program &p, const std::string &id);
 
   const Settings &settings;
   Evaluator &evaluator;  // shared instance to save memory
+
+  // evaluators and reduction contexts of the find threads; they use their
+  // own copy of the settings without a shared term store
+  Settings thread_settings;
+  std::vector<std::unique_ptr<Evaluator>> thread_evaluators;
+  std::vector<ReductionContext> thread_contexts;
+
   Optimizer optimizer;
   Minimizer minimizer;
   std::vector<std::unique_ptr<Matcher>> matchers;
-  mutable size_t num_find_attempts;
+
+  // filters of the prefix keys of the matchers
+  std::vector<Matcher::Config> matcher_configs;
+  std::vector<BloomFilter> prefix_filters;
+
+  // direct-mapped cache of fingerprints of processed output sequences
+  std::vector<uint64_t> output_cache;
+  std::string output_cache_path;
+  uint64_t output_cache_key;
+  size_t num_output_lookups;
+  size_t num_output_hits;
+
+  StepEstimateStats step_estimate_stats;
 
   std::map<size_t, int64_t> invalid_matches;
   AdaptiveScheduler scheduler;
@@ -64,6 +180,9 @@ class Finder {
   // temporary containers (cached as members)
   mutable std::unordered_set<int64_t> tmp_used_cells;
   mutable std::vector<Sequence> tmp_seqs;
-  mutable Matcher::seq_programs_t tmp_result;
+  mutable std::vector<bool> tmp_skip_cells;
+  mutable std::vector<std::vector<bool>> tmp_prefix_matches;
+  mutable std::vector<Candidate> tmp_candidates;
+  mutable ReductionContext tmp_context;
   mutable std::map<std::string, std::string> tmp_matcher_labels;
 };
@@ -0,0 +1,257 @@
+#include "mine/fingerprint_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "sys/file.hpp"
+
+uint64_t FingerprintIndex::fingerprint(const Sequence &s) {
+  uint64_t h = s.size();
+  for (const auto &n : s) {
+    h = combine(h, n.hash());
+  }
+  return h;
+}
+
+uint64_t FingerprintIndex::combine(uint64_t h, uint64_t value) {
+  // splitmix64 finalizer
+  h += value + 0x9e3779b97f4a7c15ULL;
+  h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+  return h ^ (h >> 31);
+}
+
+size_t FingerprintIndex::findSlot(uint64_t fp) const {
+  const size_t mask = num_slots - 1;
+  size_t i = fp & mask;
+  while (slots[i].start != EMPTY && slots[i].fp != fp) {
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+void FingerprintIndex::insert(uint64_t fp, size_t id) {
+  detach();
+  if (2 * (num_entries + 1) > slot_vec.size()) {
+    grow();
+  }
+  auto &slot = slot_vec[findSlot(fp)];
+  if (slot.start == EMPTY) {
+    slot = {fp, static_cast<uint32_t>(id_vec.size()), 0};
+    num_entries++;
+  } else if (slot.start + slot.count != id_vec.size()) {
+    // move the IDs to the end of the array to append the new one
+    const size_t start = slot.start;
+    for (size_t i = 0; i < slot.count; i++) {
+      id_vec.push_back(id_vec[start + i]);
+    }
+    slot.start = id_vec.size() - slot.count;
+    num_garbage += slot.count;
+  }
+  id_vec.push_back(static_cast<uint32_t>(id));
+  slot.count++;
+  sync();
+  if (num_garbage > num_ids / 2) {
+    compact();
+  }
+}
+
+void FingerprintIndex::remove(uint64_t fp, size_t id) {
+  if (num_slots == 0) {
+    return;
+  }
+  detach();
+  auto &slot = slot_vec[findSlot(fp)];
+  if (slot.start == EMPTY) {
+    return;
+  }
+  auto begin = id_vec.begin() + slot.start;
+  auto end = begin + slot.count;
+  auto it = std::find(begin, end, static_cast<uint32_t>(id));
+  if (it != end) {
+    std::copy(it + 1, end, it);
+    slot.count--;
+    num_garbage++;
+  }
+}
+
+FingerprintIndex::range_t FingerprintIndex::find(uint64_t fp) const {
+  if (num_slots == 0) {
+    return {nullptr, nullptr};
+  }
+  const auto &slot = slots[findSlot(fp)];
+  if (slot.start == EMPTY) {
+    return {nullptr, nullptr};
+  }
+  const uint32_t *begin = ids + slot.start;
+  return {begin, begin + slot.count};
+}
+
+size_t FingerprintIndex::getSizeInBytes() const {
+  if (mapped_file) {
+    return num_slots * sizeof(Slot) + num_ids * sizeof(uint32_t);
+  }
+  return slot_vec.capacity() * sizeof(Slot) +
+         id_vec.capacity() * sizeof(uint32_t);
+}
+
+void FingerprintIndex::write(std::ostream &out) const {
+  const uint64_t header[4] = {num_slots, num_ids, num_entries, num_garbage};
+  out.write(reinterpret_cast<const char *>(header), sizeof(header));
+  out.write(reinterpret_cast<const char *>(slots), num_slots * sizeof(Slot));
+  out.write(reinterpret_cast<const char *>(ids), num_ids * sizeof(uint32_t));
+  // keep the next section 8-byte aligned
+  const uint64_t zero = 0;
+  out.write(reinterpret_cast<const char *>(&zero),
+            (8 - (num_ids * sizeof(uint32_t)) % 8) % 8);
+}
+
+void FingerprintIndex::map(const std::shared_ptr<MappedFile> &file,
+                           size_t &pos) {
+  uint64_t header[4];
+  if (pos % 8 != 0 || pos + sizeof(header) > file->size()) {
+    throw std::runtime_error("invalid index header");
+  }
+  std::memcpy(header, file->data() + pos, sizeof(header));
+  const size_t slots_pos = pos + sizeof(header);
+  const size_t ids_pos = slots_pos + header[0] * sizeof(Slot);
+  const size_t ids_size = header[1] * sizeof(uint32_t);
+  const size_t end = ids_pos + ids_size + (8 - ids_size % 8) % 8;
+  if ((header[0] & (header[0] - 1)) != 0 || header[0] > file->size() ||
+      header[1] > file->size() || end > file->size() ||
+      2 * header[2] > header[0] || header[3] > header[1]) {
+    throw std::runtime_error("invalid index size");
+  }
+  auto mapped_slots = reinterpret_cast<const Slot *>(file->data() + slots_pos);
+  for (size_t i = 0; i < header[0]; i++) {
+    const auto &slot = mapped_slots[i];
+    if (slot.start != EMPTY &&
+        static_cast<uint64_t>(slot.start) + slot.count > header[1]) {
+      throw std::runtime_error("invalid index slot");
+    }
+  }
+  slot_vec.clear();
+  id_vec.clear();
+  mapped_file = file;
+  slots = mapped_slots;
+  ids = reinterpret_cast<const uint32_t *>(file->data() + ids_pos);
+  num_slots = header[0];
+  num_ids = header[1];
+  num_entries = header[2];
+  num_garbage = header[3];
+  pos = end;
+}
+
+void FingerprintIndex::detach() {
+  if (mapped_file) {
+    slot_vec.assign(slots, slots + num_slots);
+    id_vec.assign(ids, ids + num_ids);
+    mapped_file.reset();
+    sync();
+  }
+}
+
+void FingerprintIndex::sync() {
+  slots = slot_vec.data();
+  ids = id_vec.data();
+  num_slots = slot_vec.size();
+  num_ids = id_vec.size();
+}
+
+void FingerprintIndex::grow() {
+  auto old_slots = std::move(slot_vec);
+  slot_vec.assign(std::max<size_t>(1024, 2 * old_slots.size()), {0, EMPTY, 0});
+  sync();
+  for (const auto &slot : old_slots) {
+    if (slot.start != EMPTY) {
+      slot_vec[findSlot(slot.fp)] = slot;
+    }
+  }
+}
+
+void FingerprintIndex::compact() {
+  std::vector<uint32_t> packed;
+  packed.reserve(numIds());
+  for (auto &slot : slot_vec) {
+    if (slot.start != EMPTY) {
+      const size_t start = slot.start;
+      slot.start = packed.size();
+      packed.insert(packed.end(), id_vec.begin() + start,
+                    id_vec.begin() + start + slot.count);
+    }
+  }
+  id_vec = std::move(packed);
+  num_garbage = 0;
+  sync();
+}
+
+double BloomFilter::estimateRate(double bits, size_t num_hashes) {
+  // the number of fingerprints per block is Poisson distributed
+  const double mean = 512 / bits;
+  double p = std::exp(-mean), result = 0;
+  for (size_t i = 0; i < 4 * mean + 20; i++) {
+    if (i > 0) {
+      p *= mean / i;
+    }
+    result += p * std::pow(1 - std::exp(-(num_hashes * i / 512.0)),
+                           static_cast<double>(num_hashes));
+  }
+  return result;
+}
+
+void BloomFilter::init(size_t max_size, double false_positive_rate) {
+  blocks.clear();
+  num_inserted = 0;
+  this->max_size = max_size;
+  num_hashes = 0;
+  if (false_positive_rate <= 0 || false_positive_rate >= 1) {
+    return;
+  }
+  // start with the optimal number of bits per fingerprint of a standard
+  // bloom filter and add bits to compensate for the blocking
+  double bits = -std::log2(false_positive_rate) / std::log(2.0);
+  while (true) {
+    num_hashes = std::max<size_t>(
+        1, std::min<size_t>(16, std::lround(bits * std::log(2.0))));
+    if (bits >= 64 || estimateRate(bits, num_hashes) <= false_positive_rate) {
+      break;
+    }
+    bits += 0.5;
+  }
+  const size_t num_bits = std::max<double>(max_size, 1) * bits;
+  blocks.assign(std::max<size_t>(1, (num_bits + 511) / 512), Block{});
+}
+
+void BloomFilter::insert(uint64_t fp) {
+  if (blocks.empty()) {
+    return;
+  }
+  auto &block = blocks[getBlock(fp)];
+  for (size_t i = 0; i < num_hashes; i++) {
+    const uint32_t bit = getBit(fp, i);
+    block.words[bit >> 6] |= (1ULL << (bit & 63));
+  }
+  num_inserted++;
+}
+
+AgingBloomFilter::AgingBloomFilter(size_t generation_size,
+                                   double false_positive_rate,
+                                   std::chrono::seconds max_age)
+    : generation_size(generation_size),
+      false_positive_rate(false_positive_rate),
+      max_age(max_age),
+      generation_start(std::chrono::steady_clock::now()) {
+  current.init(generation_size, false_positive_rate);
+  previous.init(generation_size, false_positive_rate);
+}
+
+void AgingBloomFilter::insert(uint64_t fp) {
+  const auto now = std::chrono::steady_clock::now();
+  if (current.size() >= generation_size || now - generation_start > max_age) {
+    std::swap(current, previous);
+    current.init(generation_size, false_positive_rate);
+    generation_start = now;
+  }
+  current.insert(fp);
+}
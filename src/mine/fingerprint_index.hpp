@@ -0,0 +1,192 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "math/sequence.hpp"
+
+class MappedFile;
+
+// Compact index from 64-bit sequence fingerprints to sequence IDs. It uses an
+// open-addressed hash table with linear probing. The IDs of every fingerprint
+// are stored in a contiguous range of a packed array. Since the sequences
+// themselves are not stored, matches need to be verified using real terms.
+// The index can be written to a binary file and used directly from a memory
+// mapping of it. It is copied into memory when it is modified.
+class FingerprintIndex {
+ public:
+  using range_t = std::pair<const uint32_t *, const uint32_t *>;
+
+  FingerprintIndex() = default;
+
+  FingerprintIndex(const FingerprintIndex &) = delete;
+
+  FingerprintIndex &operator=(const FingerprintIndex &) = delete;
+
+  FingerprintIndex(FingerprintIndex &&) = default;
+
+  FingerprintIndex &operator=(FingerprintIndex &&) = default;
+
+  static uint64_t fingerprint(const Sequence &s);
+
+  static uint64_t combine(uint64_t h, uint64_t value);
+
+  void insert(uint64_t fp, size_t id);
+
+  void remove(uint64_t fp, size_t id);
+
+  range_t find(uint64_t fp) const;
+
+  // number of distinct fingerprints
+  size_t size() const { return num_entries; }
+
+  size_t numIds() const { return num_ids - num_garbage; }
+
+  size_t getSizeInBytes() const;
+
+  // call a function for all fingerprints with at least one ID
+  template <class F>
+  void forEachFingerprint(F f) const {
+    for (size_t i = 0; i < num_slots; i++) {
+      if (slots[i].start != EMPTY && slots[i].count > 0) {
+        f(slots[i].fp);
+      }
+    }
+  }
+
+  bool isMapped() const { return mapped_file != nullptr; }
+
+  void write(std::ostream &out) const;
+
+  // Use the index stored in a mapped file at the given position, which is
+  // advanced to the end of the index. Throws an exception if it is invalid.
+  void map(const std::shared_ptr<MappedFile> &file, size_t &pos);
+
+ private:
+  static constexpr uint32_t EMPTY = UINT32_MAX;
+
+  struct Slot {
+    uint64_t fp;
+    uint32_t start;
+    uint32_t count;
+  };
+
+  size_t findSlot(uint64_t fp) const;
+
+  void grow();
+
+  void compact();
+
+  // copy a mapped index into memory before modifying it
+  void detach();
+
+  void sync();
+
+  std::vector<Slot> slot_vec;
+  std::vector<uint32_t> id_vec;
+  std::shared_ptr<MappedFile> mapped_file;
+  const Slot *slots = nullptr;
+  const uint32_t *ids = nullptr;
+  size_t num_slots = 0;
+  size_t num_ids = 0;
+  size_t num_entries = 0;
+  size_t num_garbage = 0;
+};
+
+// Blocked Bloom filter of 64-bit fingerprints. All bits of a fingerprint are
+// stored in a single 512-bit block, i.e., in one cache line, so that a lookup
+// of a missing fingerprint usually needs only one memory access. The filter
+// is sized for a maximum number of fingerprints and a false positive rate.
+// Fingerprints cannot be removed. An uninitialized filter contains all
+// fingerprints.
+class BloomFilter {
+ public:
+  // Initialize an empty filter. It is disabled if the rate is not positive.
+  void init(size_t max_size, double false_positive_rate);
+
+  void insert(uint64_t fp);
+
+  bool contains(uint64_t fp) const {
+    if (blocks.empty()) {
+      return true;
+    }
+    const auto &block = blocks[getBlock(fp)];
+    for (size_t i = 0; i < num_hashes; i++) {
+      const uint32_t bit = getBit(fp, i);
+      if (!(block.words[bit >> 6] & (1ULL << (bit & 63)))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool isEnabled() const { return !blocks.empty(); }
+
+  // number of inserted fingerprints
+  size_t size() const { return num_inserted; }
+
+  size_t maxSize() const { return max_size; }
+
+  size_t getSizeInBytes() const { return blocks.size() * sizeof(Block); }
+
+ private:
+  struct alignas(64) Block {
+    uint64_t words[8];
+  };
+
+  // odd multipliers for deriving the bit positions
+  static constexpr uint32_t SALTS[16] = {
+      0x47b6137b, 0x44974d91, 0x8824ad5b, 0xa2b7289d, 0x705495c7, 0x2df1424b,
+      0x9efc4947, 0x5c6bfb31, 0x3c6ef373, 0xa54ff53b, 0x510e527f, 0x9b05688d,
+      0x1f83d9ab, 0x5be0cd19, 0xcbbb9d5d, 0x629a292b};
+
+  // Estimated false positive rate for the given number of bits per
+  // fingerprint and hash functions, taking the varying block loads into
+  // account.
+  static double estimateRate(double bits, size_t num_hashes);
+
+  size_t getBlock(uint64_t fp) const {
+    // map the upper bits to the block range without a division
+    return ((fp >> 32) * blocks.size()) >> 32;
+  }
+
+  static uint32_t getBit(uint64_t fp, size_t i) {
+    return (static_cast<uint32_t>(fp) * SALTS[i]) >> 23;
+  }
+
+  std::vector<Block> blocks;
+  size_t num_hashes = 0;
+  size_t num_inserted = 0;
+  size_t max_size = 0;
+};
+
+// Approximate set of fingerprints with bounded memory and decay. It consists
+// of bloom filters for the current and the previous generation. Fingerprints
+// are inserted into the current generation, which replaces the previous one
+// when it is full or older than the maximum age. Hence, fingerprints are
+// forgotten after one to two generations.
+class AgingBloomFilter {
+ public:
+  AgingBloomFilter(size_t generation_size, double false_positive_rate,
+                   std::chrono::seconds max_age);
+
+  bool contains(uint64_t fp) const {
+    return current.contains(fp) || previous.contains(fp);
+  }
+
+  void insert(uint64_t fp);
+
+  size_t getSizeInBytes() const {
+    return current.getSizeInBytes() + previous.getSizeInBytes();
+  }
+
+ private:
+  const size_t generation_size;
+  const double false_positive_rate;
+  const std::chrono::seconds max_age;
+  std::chrono::steady_clock::time_point generation_start;
+  BloomFilter current;
+  BloomFilter previous;
+};
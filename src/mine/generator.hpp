@@ -79,6 +79,10 @@ class MultiGenerator : public Generator {
 
   virtual bool isFinished() const override;
 
+  const Generator::Config &getCurrentConfig() const {
+    return configs[current_generator];
+  }
+
  private:
   std::vector<Generator::Config> configs;
   std::vector<Generator::UPtr> generators;
@@ -1,8 +1,14 @@
 #include "mine/matcher.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+
 #include "eval/optimizer.hpp"
 #include "eval/semantics.hpp"
 #include "mine/reducer.hpp"
+#include "sys/file.hpp"
 #include "sys/log.hpp"
 
 // --- Factory --------------------------------------------------------
@@ -21,9 +27,12 @@ Matcher::UPtr Matcher::Factory::create(const Matcher::Config &config) {
     result.reset(new DigitMatcher("binary", 2, config.backoff));
   } else if (config.type == "decimal") {
     result.reset(new DigitMatcher("decimal", 10, config.backoff));
+  } else if (config.type == "shift") {
+    result.reset(new ShiftMatcher());
   } else {
     Log::get().error("Unknown matcher type: " + config.type, true);
   }
+  result->setFilterRate(config.filter_rate);
   return result;
 }
 
@@ -31,101 +40,309 @@ Matcher::UPtr Matcher::Factory::create(const Matcher::Config &config) {
 
 template <class T>
 void AbstractMatcher<T>::insert(const Sequence &norm_seq, size_t id) {
-  auto reduced = reduce(norm_seq, false);
-  if (!reduced.first.empty()) {
-    data[id] = reduced.second;
-    ids[reduced.first].push_back(id);
+  if (removed_ids.erase(id)) {
+    return;  // still contained in the index
   }
+  Sequence reduced = norm_seq;
+  auto value = reduce(reduced, false);
+  if (!reduced.empty()) {
+    if (id >= data.size()) {
+      data.resize(id + 1);
+    }
+    data[id] = value;
+    const auto fp = FingerprintIndex::fingerprint(reduced);
+    index.insert(fp, id);
+    if (filter.size() < filter.maxSize()) {
+      filter.insert(fp);
+    } else {
+      rebuildFilter();
+    }
+  }
+}
+
+template <class T>
+void AbstractMatcher<T>::rebuildFilter() {
+  // reserve space for growing indexes to avoid frequent rebuilds
+  filter.init(std::max<size_t>(1024, 2 * index.size()), filter_rate);
+  index.forEachFingerprint([this](uint64_t fp) { filter.insert(fp); });
+}
+
+template <class T>
+void AbstractMatcher<T>::setFilterRate(double rate) {
+  filter_rate = rate;
+  rebuildFilter();
+}
+
+template <class T>
+Matcher::FilterStats AbstractMatcher<T>::getFilterStats() const {
+  return {filter.getSizeInBytes(), filter.isEnabled() ? filter_rate : 0.0,
+          num_filter_misses.load(), num_filter_false_positives.load()};
 }
 
 template <class T>
 void AbstractMatcher<T>::remove(const Sequence &norm_seq, size_t id) {
-  auto reduced = reduce(norm_seq, false);
-  if (!reduced.first.empty()) {
-    ids.remove(reduced.first, id);
-    data.erase(id);
+  if (index.isMapped()) {
+    // keep the mapped index shared with other processes
+    removed_ids.insert(id);
+    return;
+  }
+  Sequence reduced = norm_seq;
+  reduce(reduced, false);
+  if (!reduced.empty()) {
+    index.remove(FingerprintIndex::fingerprint(reduced), id);
+  }
+}
+
+void Matcher::match(const Program &p, const Sequence &norm_seq,
+                    seq_programs_t &result) const {
+  ReductionContext ctx;
+  configure(ctx);
+  ctx.init(norm_seq);
+  matches_t matches;
+  match(norm_seq, ctx, matches);
+  for (const auto &m : matches) {
+    Program copy = p;
+    if (extendProgram(copy, m)) {
+      result.push_back(std::pair<size_t, Program>(m.id, std::move(copy)));
+    }
   }
 }
 
+// the back off state and the random generator are shared by the find threads
+static std::mutex backoff_mutex;
+
+bool Matcher::randomBackoff() {
+  std::lock_guard<std::mutex> lock(backoff_mutex);
+  return (Random::get().gen() % 10) == 0;  // magic number
+}
+
 template <class T>
-void AbstractMatcher<T>::match(const Program &p, const Sequence &norm_seq,
-                               seq_programs_t &result) const {
+bool AbstractMatcher<T>::match(const Sequence &norm_seq, ReductionContext &ctx,
+                               matches_t &result) const {
   if (!shouldMatchSequence(norm_seq)) {
-    return;
+    return false;
   }
-  auto reduced = reduce(norm_seq, true);
-  if (!shouldMatchSequence(reduced.first) && norm_seq != reduced.first) {
-    return;
+  const auto &reduced = ctx.buffer;
+  const auto value = reduceMatch(norm_seq, ctx, ctx.buffer);
+  if (!shouldMatchSequence(reduced) && norm_seq != reduced) {
+    return false;
   }
-  auto it = ids.find(reduced.first);
-  if (it != ids.end()) {
-    for (auto id : it->second) {
-      Program copy = p;
-      if (extend(copy, data.at(id), reduced.second)) {
-        result.push_back(std::pair<size_t, Program>(id, copy));
-        if (backoff && (Random::get().gen() % 10) == 0)  // magic number
-        {
-          // avoid to many matches for the same sequence
-          break;
-        }
-      }
+  const auto fp = FingerprintIndex::fingerprint(reduced);
+  if (!filter.contains(fp)) {
+    num_filter_misses.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  auto range = index.find(fp);
+  if (range.first == range.second) {
+    num_filter_misses.fetch_add(1, std::memory_order_relaxed);
+    if (filter.isEnabled()) {
+      num_filter_false_positives.fetch_add(1, std::memory_order_relaxed);
     }
+    return true;
+  }
+  std::shared_ptr<const T> params;
+  for (auto it = range.first; it != range.second; ++it) {
+    const size_t id = *it;
+    if (!removed_ids.empty() && removed_ids.count(id)) {
+      continue;
+    }
+    if (!params) {
+      params = std::make_shared<const T>(value);
+    }
+    result.push_back({id, params});
+  }
+  return true;
+}
+
+template <class T>
+bool AbstractMatcher<T>::extendProgram(Program &p, const Match &m) const {
+  return extend(p, data.at(m.id), *static_cast<const T *>(m.params.get()));
+}
+
+template <class T>
+bool AbstractMatcher<T>::verify(const Sequence &norm_seq,
+                                const Sequence &matched_seq) const {
+  Sequence a = norm_seq, b = matched_seq;
+  reduce(a, true);
+  reduce(b, false);
+  return a == b;
+}
+
+// text serialization of the matcher data
+
+void writeValue(std::ostream &out, int v) { out << v; }
+
+void writeValue(std::ostream &out, int64_t v) { out << v; }
+
+void writeValue(std::ostream &out, const line_t &v) {
+  out << v.offset << " " << v.factor;
+}
+
+void writeValue(std::ostream &out, const delta_t &v) {
+  out << v.delta << " " << v.offset << " " << v.factor;
+}
+
+Number readNumber(std::istream &in) {
+  std::string s;
+  in >> s;
+  return Number(s);
+}
+
+void readValue(std::istream &in, int &v) { in >> v; }
+
+void readValue(std::istream &in, int64_t &v) { in >> v; }
+
+void readValue(std::istream &in, line_t &v) {
+  v.offset = readNumber(in);
+  v.factor = readNumber(in);
+}
+
+void readValue(std::istream &in, delta_t &v) {
+  in >> v.delta;
+  v.offset = readNumber(in);
+  v.factor = readNumber(in);
+}
+
+template <class T>
+void AbstractMatcher<T>::writeIndex(std::ostream &out) const {
+  index.write(out);
+  std::stringstream buf;
+  buf << data.size() << "\n";
+  for (const auto &v : data) {
+    writeValue(buf, v);
+    buf << "\n";
   }
+  const std::string str = buf.str();
+  const uint64_t length = str.size();
+  out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+  out.write(str.data(), length);
+  const uint64_t zero = 0;
+  out.write(reinterpret_cast<const char *>(&zero), (8 - length % 8) % 8);
+}
+
+template <class T>
+void AbstractMatcher<T>::mapIndex(const std::shared_ptr<MappedFile> &file,
+                                  size_t &pos) {
+  FingerprintIndex new_index;
+  new_index.map(file, pos);
+  uint64_t length;
+  if (pos + sizeof(length) > file->size()) {
+    throw std::runtime_error("invalid matcher data");
+  }
+  std::memcpy(&length, file->data() + pos, sizeof(length));
+  pos += sizeof(length);
+  if (length > file->size() - pos) {
+    throw std::runtime_error("invalid matcher data");
+  }
+  std::stringstream buf(std::string(file->data() + pos, length));
+  size_t size = 0;
+  buf >> size;
+  std::vector<T> new_data(std::min<size_t>(size, length));
+  for (auto &v : new_data) {
+    readValue(buf, v);
+  }
+  if (!buf || new_data.size() != size) {
+    throw std::runtime_error("invalid matcher data");
+  }
+  pos += length + (8 - length % 8) % 8;
+  index = std::move(new_index);
+  data = std::move(new_data);
+  removed_ids.clear();
+  rebuildFilter();
 }
 
 template <class T>
 bool AbstractMatcher<T>::shouldMatchSequence(const Sequence &seq) const {
   if (backoff) {
-    if (match_attempts.find(seq) != match_attempts.end()) {
+    const auto fp = FingerprintIndex::fingerprint(seq);
+    std::lock_guard<std::mutex> lock(backoff_mutex);
+    if (match_attempts.contains(fp)) {
       // Log::get().debug( "Back off matching of already matched sequence " +
       // seq.to_string() );
       return false;
     }
-    if ((has_memory || match_attempts.size() < 1000) &&  // magic number
-        (Random::get().gen() % 10) == 0)                 // magic number
+    if ((Random::get().gen() % 10) == 0)  // magic number
     {
-      match_attempts.insert(seq);
+      match_attempts.insert(fp);
+    }
+  }
+  return true;
+}
+
+// Key of the differences of consecutive terms divided by their gcd. It is
+// invariant under the transformations of the linear matchers, i.e., adding an
+// offset and multiplying with a positive factor.
+bool getLinearPrefixKey(const Sequence &prefix, uint64_t &key) {
+  Sequence deltas;
+  Number factor = Number::ZERO;
+  for (size_t i = 0; i + 1 < prefix.size(); i++) {
+    deltas.push_back(Semantics::sub(prefix[i + 1], prefix[i]));
+    factor = Semantics::gcd(factor, deltas.back());
+    if (deltas.back() == Number::INF || factor == Number::INF) {
+      return false;
     }
   }
+  if (factor != Number::ZERO && factor != Number::ONE) {
+    for (auto &d : deltas) {
+      d = Semantics::div(d, factor);
+    }
+  }
+  key = FingerprintIndex::fingerprint(deltas);
   return true;
 }
 
 // --- Direct Matcher ---------------------------------------------------------
 
-std::pair<Sequence, int> DirectMatcher::reduce(const Sequence &seq,
-                                               bool match) const {
-  std::pair<Sequence, int> result;
-  result.first = seq;
-  result.second = 0;
-  return result;
+bool DirectMatcher::getPrefixKey(const Sequence &prefix, uint64_t &key) const {
+  key = FingerprintIndex::fingerprint(prefix);
+  return true;
 }
 
+int DirectMatcher::reduce(Sequence &seq, bool match) const { return 0; }
+
 bool DirectMatcher::extend(Program &p, int base, int gen) const { return true; }
 
 // --- Linear Matcher ---------------------------------------------------------
 
-std::pair<Sequence, line_t> LinearMatcher::reduce(const Sequence &seq,
-                                                  bool match) const {
-  std::pair<Sequence, line_t> result;
-  result.first = seq;
-  result.second.offset = Reducer::truncate(result.first);
-  result.second.factor = Reducer::shrink(result.first);
+bool LinearMatcher::getPrefixKey(const Sequence &prefix, uint64_t &key) const {
+  return getLinearPrefixKey(prefix, key);
+}
+
+line_t LinearMatcher::reduce(Sequence &seq, bool match) const {
+  line_t result;
+  result.offset = Reducer::truncate(seq);
+  result.factor = Reducer::shrink(seq);
   return result;
 }
 
+line_t LinearMatcher::reduceMatch(const Sequence &seq,
+                                  const ReductionContext &ctx,
+                                  Sequence &result) const {
+  return Reducer::linear1(seq, ctx, result);
+}
+
 bool LinearMatcher::extend(Program &p, line_t base, line_t gen) const {
   return Extender::linear1(p, gen, base);
 }
 
-std::pair<Sequence, line_t> LinearMatcher2::reduce(const Sequence &seq,
-                                                   bool match) const {
-  std::pair<Sequence, line_t> result;
-  result.first = seq;
-  result.second.factor = Reducer::shrink(result.first);
-  result.second.offset = Reducer::truncate(result.first);
+bool LinearMatcher2::getPrefixKey(const Sequence &prefix,
+                                  uint64_t &key) const {
+  return getLinearPrefixKey(prefix, key);
+}
+
+line_t LinearMatcher2::reduce(Sequence &seq, bool match) const {
+  line_t result;
+  result.factor = Reducer::shrink(seq);
+  result.offset = Reducer::truncate(seq);
   return result;
 }
 
+line_t LinearMatcher2::reduceMatch(const Sequence &seq,
+                                   const ReductionContext &ctx,
+                                   Sequence &result) const {
+  return Reducer::linear2(seq, ctx, result);
+}
+
 bool LinearMatcher2::extend(Program &p, line_t base, line_t gen) const {
   return Extender::linear2(p, gen, base);
 }
@@ -134,14 +351,9 @@ bool LinearMatcher2::extend(Program &p, line_t base, line_t gen) const {
 
 const int64_t DeltaMatcher::MAX_DELTA = 4;  // magic number
 
-std::pair<Sequence, delta_t> DeltaMatcher::reduce(const Sequence &seq,
-                                                  bool match) const {
-  std::pair<Sequence, delta_t> result;
-  result.first = seq;
-  result.second = Reducer::delta(result.first, MAX_DELTA);
-  return result;
+delta_t DeltaMatcher::reduce(Sequence &seq, bool match) const {
+  return Reducer::delta(seq, MAX_DELTA);
 }
-
 bool DeltaMatcher::extend(Program &p, delta_t base, delta_t gen) const {
   if (base.offset == gen.offset && base.factor == gen.factor) {
     return Extender::delta_it(p, base.delta - gen.delta);
@@ -167,22 +379,207 @@ bool DeltaMatcher::extend(Program &p, delta_t base, delta_t gen) const {
 
 // --- Digit Matcher ----------------------------------------------------------
 
-std::pair<Sequence, int64_t> DigitMatcher::reduce(const Sequence &seq,
-                                                  bool match) const {
-  std::pair<Sequence, int64_t> result;
-  result.first = seq;
-  result.second = Reducer::digit(result.first, num_digits);
+bool DigitMatcher::getPrefixKey(const Sequence &prefix, uint64_t &key) const {
+  // differences of the digits are invariant under the digit offset
+  Sequence deltas;
+  for (size_t i = 0; i + 1 < prefix.size(); i++) {
+    auto d = Semantics::sub(prefix[i + 1], prefix[i]);
+    d = Semantics::mod(
+        Semantics::add(Semantics::mod(d, num_digits_big), num_digits_big),
+        num_digits_big);
+    if (d == Number::INF) {
+      return false;
+    }
+    deltas.push_back(d);
+  }
+  key = FingerprintIndex::fingerprint(deltas);
+  return true;
+}
+
+int64_t DigitMatcher::reduce(Sequence &seq, bool match) const {
   if (!match) {
     for (auto &n : seq) {
       if (n < Number::ZERO || !(n < num_digits_big)) {
-        result.first.clear();
-        break;
+        seq.clear();
+        return 0;
       }
     }
   }
-  return result;
+  return Reducer::digit(seq, num_digits);
+}
+
+int64_t DigitMatcher::reduceMatch(const Sequence &seq,
+                                  const ReductionContext &ctx,
+                                  Sequence &result) const {
+  return Reducer::digit(seq, ctx, num_digits, result);
 }
 
 bool DigitMatcher::extend(Program &p, int64_t base, int64_t gen) const {
   return Extender::digit(p, num_digits, base - gen);
 }
+
+// --- ShiftMatcher -----------------------------------------------------------
+
+// the index entries encode the sequence ID and the start of the window
+static constexpr int64_t NUM_SHIFT_WINDOWS = ShiftMatcher::MAX_SHIFT + 1;
+
+bool ShiftMatcher::getWindow(const Sequence &seq, int64_t start,
+                             Sequence &window) {
+  if (seq.size() < MIN_WINDOW_LENGTH + MAX_SHIFT) {
+    return false;
+  }
+  window.assign(seq.begin() + start,
+                seq.begin() + start + (seq.size() - MAX_SHIFT));
+  return true;
+}
+
+void ShiftMatcher::insert(const Sequence &norm_seq, size_t id) {
+  if (removed_ids.erase(id)) {
+    return;  // still contained in the index
+  }
+  Sequence window;
+  for (int64_t b = 0; b < NUM_SHIFT_WINDOWS; b++) {
+    if (!getWindow(norm_seq, b, window)) {
+      return;
+    }
+    const auto fp = FingerprintIndex::fingerprint(window);
+    index.insert(fp, (id * NUM_SHIFT_WINDOWS) + b);
+    if (filter.size() < filter.maxSize()) {
+      filter.insert(fp);
+    } else {
+      rebuildFilter();
+    }
+  }
+}
+
+void ShiftMatcher::remove(const Sequence &norm_seq, size_t id) {
+  if (index.isMapped()) {
+    // keep the mapped index shared with other processes
+    removed_ids.insert(id);
+    return;
+  }
+  Sequence window;
+  for (int64_t b = 0; b < NUM_SHIFT_WINDOWS; b++) {
+    if (getWindow(norm_seq, b, window)) {
+      index.remove(FingerprintIndex::fingerprint(window),
+                   (id * NUM_SHIFT_WINDOWS) + b);
+    }
+  }
+}
+
+bool ShiftMatcher::match(const Sequence &norm_seq, ReductionContext &ctx,
+                         matches_t &result) const {
+  // shifts of the matched sequences in the order they were found
+  std::vector<std::pair<size_t, int64_t>> shifts;
+  std::unordered_set<size_t> unshifted;
+  auto &window = ctx.buffer;
+  for (int64_t a = 0; a < NUM_SHIFT_WINDOWS; a++) {
+    if (!getWindow(norm_seq, a, window)) {
+      return true;
+    }
+    const auto fp = FingerprintIndex::fingerprint(window);
+    if (!filter.contains(fp)) {
+      num_filter_misses.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    auto range = index.find(fp);
+    if (range.first == range.second) {
+      num_filter_misses.fetch_add(1, std::memory_order_relaxed);
+      if (filter.isEnabled()) {
+        num_filter_false_positives.fetch_add(1, std::memory_order_relaxed);
+      }
+      continue;
+    }
+    for (auto it = range.first; it != range.second; ++it) {
+      const size_t id = *it / NUM_SHIFT_WINDOWS;
+      const int64_t b = *it % NUM_SHIFT_WINDOWS;
+      if (!removed_ids.empty() && removed_ids.count(id)) {
+        continue;
+      }
+      // term n of the matched sequence is term n+shift of the candidate;
+      // negative shifts are not supported, because the candidate would not
+      // cover the first terms of the matched sequence
+      const int64_t shift = a - b;
+      if (shift == 0) {
+        unshifted.insert(id);
+      }
+      if (shift <= 0) {
+        continue;
+      }
+      bool found = false;
+      for (auto &s : shifts) {
+        if (s.first == id) {
+          if (shift < s.second) {
+            s.second = shift;
+          }
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        shifts.push_back({id, shift});
+      }
+    }
+  }
+  std::shared_ptr<const int64_t> params[MAX_SHIFT + 1];
+  for (const auto &s : shifts) {
+    if (unshifted.count(s.first)) {
+      continue;
+    }
+    auto &param = params[s.second];
+    if (!param) {
+      param = std::make_shared<const int64_t>(s.second);
+    }
+    result.push_back({s.first, param});
+  }
+  return true;
+}
+
+bool ShiftMatcher::extendProgram(Program &p, const Match &m) const {
+  return Extender::shift(p, *static_cast<const int64_t *>(m.params.get()));
+}
+
+bool ShiftMatcher::verify(const Sequence &norm_seq,
+                          const Sequence &matched_seq) const {
+  // the windows do not contain the leading terms of the matched sequence,
+  // so all of its terms must agree with the shifted candidate
+  for (int64_t shift = 1; shift <= MAX_SHIFT; shift++) {
+    if (norm_seq.size() <= static_cast<size_t>(shift)) {
+      break;
+    }
+    const size_t length =
+        std::min(matched_seq.size(), norm_seq.size() - shift);
+    if (std::equal(matched_seq.begin(), matched_seq.begin() + length,
+                   norm_seq.begin() + shift)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ShiftMatcher::writeIndex(std::ostream &out) const { index.write(out); }
+
+void ShiftMatcher::mapIndex(const std::shared_ptr<MappedFile> &file,
+                            size_t &pos) {
+  FingerprintIndex new_index;
+  new_index.map(file, pos);
+  index = std::move(new_index);
+  removed_ids.clear();
+  rebuildFilter();
+}
+
+void ShiftMatcher::rebuildFilter() {
+  // reserve space for growing indexes to avoid frequent rebuilds
+  filter.init(std::max<size_t>(1024, 2 * index.size()), filter_rate);
+  index.forEachFingerprint([this](uint64_t fp) { filter.insert(fp); });
+}
+
+void ShiftMatcher::setFilterRate(double rate) {
+  filter_rate = rate;
+  rebuildFilter();
+}
+
+Matcher::FilterStats ShiftMatcher::getFilterStats() const {
+  return {filter.getSizeInBytes(), filter.isEnabled() ? filter_rate : 0.0,
+          num_filter_misses.load(), num_filter_false_positives.load()};
+}
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <unordered_set>
 
 #include "lang/program.hpp"
 #include "mine/extender.hpp"
+#include "mine/fingerprint_index.hpp"
 #include "mine/reducer.hpp"
 
 class Matcher {
@@ -17,6 +19,16 @@ class Matcher {
    public:
     std::string type;
     bool backoff;
+    double filter_rate;  // target false positive rate of the filter
+  };
+
+  // statistics of the filter in front of the index lookups
+  class FilterStats {
+   public:
+    size_t size_in_bytes;
+    double target_rate;
+    size_t num_misses;  // lookups of fingerprints not contained in the index
+    size_t num_false_positives;  // misses not rejected by the filter
   };
 
   class Factory {
@@ -30,21 +42,86 @@ class Matcher {
 
   virtual void remove(const Sequence &norm_seq, size_t id) = 0;
 
-  virtual void match(const Program &p, const Sequence &norm_seq,
-                     seq_programs_t &result) const = 0;
+  // Potential match of a sequence. Programs are extended only on demand,
+  // because most matches are rejected by the verification.
+  class Match {
+   public:
+    size_t id;
+    // parameters of the extension, which are specific to the matcher and
+    // shared by the matches of a sequence
+    std::shared_ptr<const void> params;
+  };
+
+  using matches_t = std::vector<Match>;
+
+  // Match a sequence and extend the program for all matches.
+  void match(const Program &p, const Sequence &norm_seq,
+             seq_programs_t &result) const;
+
+  // Match a sequence using the statistics and buffer of a context, which was
+  // initialized for the sequence and can be shared by all matchers. Returns
+  // false if the matcher backed off from matching the sequence, i.e., the
+  // result may be incomplete.
+  virtual bool match(const Sequence &norm_seq, ReductionContext &ctx,
+                     matches_t &result) const = 0;
+
+  // Extend a program for a match of this matcher. Returns false if it cannot
+  // be extended.
+  virtual bool extendProgram(Program &p, const Match &m) const = 0;
+
+  // Register the statistics needed by this matcher in a reduction context.
+  virtual void configure(ReductionContext &ctx) const {}
 
   virtual const std::string &getName() const = 0;
 
   virtual double getCompationRatio() const = 0;
 
-  bool has_memory = true;
+  // size of the index in bytes
+  virtual size_t getIndexSize() const = 0;
+
+  // Check whether a match for the given sequence is real, i.e., not caused by
+  // a fingerprint collision, using the terms of the matched sequence.
+  virtual bool verify(const Sequence &norm_seq,
+                      const Sequence &matched_seq) const = 0;
+
+  virtual void writeIndex(std::ostream &out) const = 0;
+
+  // Use an index stored in a mapped file at the given position, which is
+  // advanced to the end of the index. Throws an exception if it is invalid.
+  virtual void mapIndex(const std::shared_ptr<MappedFile> &file,
+                        size_t &pos) = 0;
+
+  // Compute a key of the first terms of a sequence. Sequences that can be
+  // matched with each other have equal keys. Returns false if the key is not
+  // supported by the matcher or cannot be computed for the terms.
+  virtual bool getPrefixKey(const Sequence &prefix, uint64_t &key) const {
+    return false;
+  }
+
+  // Set the target false positive rate of the filter in front of the index
+  // lookups. The filter is disabled if the rate is zero.
+  virtual void setFilterRate(double rate) = 0;
+
+  virtual FilterStats getFilterStats() const = 0;
+
+  // Whether the finder randomly stops processing further matches of a
+  // sequence after a match was verified.
+  virtual bool hasBackoff() const { return false; }
+
+  // Randomly decide to back off. Can be called concurrently.
+  static bool randomBackoff();
+
+  static constexpr double DEFAULT_FILTER_RATE = 0.01;
 };
 
 template <class T>
 class AbstractMatcher : public Matcher {
  public:
   AbstractMatcher(const std::string &name, bool backoff)
-      : name(name), backoff(backoff) {}
+      : name(name),
+        match_attempts(backoff ? BACKOFF_GENERATION_SIZE : 0,
+                       BACKOFF_FILTER_RATE, BACKOFF_MAX_AGE),
+        backoff(backoff) {}
 
   virtual ~AbstractMatcher() {}
 
@@ -52,28 +129,71 @@ class AbstractMatcher : public Matcher {
 
   virtual void remove(const Sequence &norm_seq, size_t id) override;
 
-  virtual void match(const Program &p, const Sequence &norm_seq,
-                     seq_programs_t &result) const override;
+  using Matcher::match;
+
+  virtual bool match(const Sequence &norm_seq, ReductionContext &ctx,
+                     matches_t &result) const override;
+
+  virtual bool extendProgram(Program &p, const Match &m) const override;
 
   virtual const std::string &getName() const override { return name; }
 
   virtual double getCompationRatio() const override {
-    return 100.0 - (100.0 * ids.size() / std::max<size_t>(data.size(), 1));
+    return 100.0 -
+           (100.0 * index.size() / std::max<size_t>(index.numIds(), 1));
   }
 
+  virtual size_t getIndexSize() const override {
+    return index.getSizeInBytes() + data.capacity() * sizeof(T);
+  }
+
+  virtual bool verify(const Sequence &norm_seq,
+                      const Sequence &matched_seq) const override;
+
+  virtual void writeIndex(std::ostream &out) const override;
+
+  virtual void mapIndex(const std::shared_ptr<MappedFile> &file,
+                        size_t &pos) override;
+
+  virtual void setFilterRate(double rate) override;
+
+  virtual FilterStats getFilterStats() const override;
+
+  virtual bool hasBackoff() const override { return backoff; }
+
  protected:
-  virtual std::pair<Sequence, T> reduce(const Sequence &seq,
-                                        bool match) const = 0;
+  // Reduce a sequence in place. The sequence is cleared if it cannot be
+  // reduced.
+  virtual T reduce(Sequence &seq, bool match) const = 0;
+
+  // Reduce a sequence for matching using the statistics of the context.
+  virtual T reduceMatch(const Sequence &seq, const ReductionContext &ctx,
+                        Sequence &result) const {
+    result = seq;
+    return reduce(result, true);
+  }
 
   virtual bool extend(Program &p, T base, T gen) const = 0;
 
  private:
   bool shouldMatchSequence(const Sequence &seq) const;
 
+  void rebuildFilter();
+
   std::string name;
-  SequenceToIdsMap ids;
-  std::unordered_map<size_t, T> data;
-  mutable std::unordered_set<Sequence, SequenceHasher> match_attempts;
+  FingerprintIndex index;
+  BloomFilter filter;
+  double filter_rate = DEFAULT_FILTER_RATE;
+  mutable std::atomic<size_t> num_filter_misses{0};
+  mutable std::atomic<size_t> num_filter_false_positives{0};
+  std::vector<T> data;
+  // removed IDs of a mapped index, which is not modified to keep it shared
+  std::unordered_set<size_t> removed_ids;
+  // recently matched sequences for backing off
+  static constexpr size_t BACKOFF_GENERATION_SIZE = 100000;
+  static constexpr double BACKOFF_FILTER_RATE = 0.01;
+  static constexpr std::chrono::seconds BACKOFF_MAX_AGE{3600};
+  mutable AgingBloomFilter match_attempts;
   bool backoff;
 };
 
@@ -83,9 +203,11 @@ class DirectMatcher : public AbstractMatcher<int> {
 
   virtual ~DirectMatcher() {}
 
+  virtual bool getPrefixKey(const Sequence &prefix,
+                            uint64_t &key) const override;
+
  protected:
-  virtual std::pair<Sequence, int> reduce(const Sequence &seq,
-                                          bool match) const override;
+  virtual int reduce(Sequence &seq, bool match) const override;
 
   virtual bool extend(Program &p, int base, int gen) const override;
 };
@@ -96,9 +218,14 @@ class LinearMatcher : public AbstractMatcher<line_t> {
 
   virtual ~LinearMatcher() {}
 
+  virtual bool getPrefixKey(const Sequence &prefix,
+                            uint64_t &key) const override;
+
  protected:
-  virtual std::pair<Sequence, line_t> reduce(const Sequence &seq,
-                                             bool match) const override;
+  virtual line_t reduce(Sequence &seq, bool match) const override;
+
+  virtual line_t reduceMatch(const Sequence &seq, const ReductionContext &ctx,
+                             Sequence &result) const override;
 
   virtual bool extend(Program &p, line_t base, line_t gen) const override;
 };
@@ -109,9 +236,14 @@ class LinearMatcher2 : public AbstractMatcher<line_t> {
 
   virtual ~LinearMatcher2() {}
 
+  virtual bool getPrefixKey(const Sequence &prefix,
+                            uint64_t &key) const override;
+
  protected:
-  virtual std::pair<Sequence, line_t> reduce(const Sequence &seq,
-                                             bool match) const override;
+  virtual line_t reduce(Sequence &seq, bool match) const override;
+
+  virtual line_t reduceMatch(const Sequence &seq, const ReductionContext &ctx,
+                             Sequence &result) const override;
 
   virtual bool extend(Program &p, line_t base, line_t gen) const override;
 };
@@ -125,8 +257,7 @@ class DeltaMatcher : public AbstractMatcher<delta_t> {
   virtual ~DeltaMatcher() {}
 
  protected:
-  virtual std::pair<Sequence, delta_t> reduce(const Sequence &seq,
-                                              bool match) const override;
+  virtual delta_t reduce(Sequence &seq, bool match) const override;
 
   virtual bool extend(Program &p, delta_t base, delta_t gen) const override;
 };
@@ -140,9 +271,18 @@ class DigitMatcher : public AbstractMatcher<int64_t> {
 
   virtual ~DigitMatcher() {}
 
+  virtual void configure(ReductionContext &ctx) const override {
+    ctx.addDigitBase(num_digits);
+  }
+
+  virtual bool getPrefixKey(const Sequence &prefix,
+                            uint64_t &key) const override;
+
  protected:
-  virtual std::pair<Sequence, int64_t> reduce(const Sequence &seq,
-                                              bool match) const override;
+  virtual int64_t reduce(Sequence &seq, bool match) const override;
+
+  virtual int64_t reduceMatch(const Sequence &seq, const ReductionContext &ctx,
+                              Sequence &result) const override;
 
   virtual bool extend(Program &p, int64_t base, int64_t gen) const override;
 
@@ -150,3 +290,70 @@ class DigitMatcher : public AbstractMatcher<int64_t> {
   const int64_t num_digits;
   const Number num_digits_big;
 };
+
+// Matcher for sequences that agree with a candidate after shifting their
+// indices by a few terms. The index contains the fingerprints of windows of
+// the sequences that start at one of the first terms. The positions of equal
+// windows of a candidate and an indexed sequence determine the shift, which
+// is applied to the argument of the program. Only positive shifts are used,
+// so that the candidate covers all terms of the matched sequence. Unshifted
+// matches are left to the direct matcher.
+class ShiftMatcher : public Matcher {
+ public:
+  static constexpr int64_t MAX_SHIFT = 2;
+
+  ShiftMatcher() : name("shift") {}
+
+  virtual ~ShiftMatcher() {}
+
+  virtual void insert(const Sequence &norm_seq, size_t id) override;
+
+  virtual void remove(const Sequence &norm_seq, size_t id) override;
+
+  using Matcher::match;
+
+  virtual bool match(const Sequence &norm_seq, ReductionContext &ctx,
+                     matches_t &result) const override;
+
+  virtual bool extendProgram(Program &p, const Match &m) const override;
+
+  virtual const std::string &getName() const override { return name; }
+
+  virtual double getCompationRatio() const override {
+    return 100.0 -
+           (100.0 * index.size() / std::max<size_t>(index.numIds(), 1));
+  }
+
+  virtual size_t getIndexSize() const override {
+    return index.getSizeInBytes();
+  }
+
+  virtual bool verify(const Sequence &norm_seq,
+                      const Sequence &matched_seq) const override;
+
+  virtual void writeIndex(std::ostream &out) const override;
+
+  virtual void mapIndex(const std::shared_ptr<MappedFile> &file,
+                        size_t &pos) override;
+
+  virtual void setFilterRate(double rate) override;
+
+  virtual FilterStats getFilterStats() const override;
+
+ private:
+  // minimum number of terms of the windows
+  static constexpr size_t MIN_WINDOW_LENGTH = 4;
+
+  static bool getWindow(const Sequence &seq, int64_t start, Sequence &window);
+
+  void rebuildFilter();
+
+  std::string name;
+  FingerprintIndex index;
+  BloomFilter filter;
+  double filter_rate = DEFAULT_FILTER_RATE;
+  mutable std::atomic<size_t> num_filter_misses{0};
+  mutable std::atomic<size_t> num_filter_false_positives{0};
+  // removed IDs of a mapped index, which is not modified to keep it shared
+  std::unordered_set<size_t> removed_ids;
+};
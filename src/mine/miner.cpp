@@ -8,6 +8,7 @@
 
 #include "eval/interpreter.hpp"
 #include "eval/optimizer.hpp"
+#include "lang/analyzer.hpp"
 #include "lang/comments.hpp"
 #include "lang/parser.hpp"
 #include "lang/program_util.hpp"
@@ -42,6 +43,9 @@ Miner::Miner(const Settings &settings, ProgressMonitor *progress_monitor)
       current_fetch(0) {}
 
 void Miner::reload() {
+  if (manager) {
+    manager->getFinder().saveOutputCache();
+  }
   api_client.reset(new ApiClient());
   manager.reset(new OeisManager(settings));
   manager->load();
@@ -160,6 +164,7 @@ void Miner::runMineLoop() {
 
     // start with constants mutations; later do random mutation
     mutator->mutateCopiesConstants(base_program, NUM_MUTATIONS, progs);
+    mutation_parents.insert(base_program);
   }
 
   // print info
@@ -178,11 +183,13 @@ void Miner::runMineLoop() {
 
   std::string submitted_by;
   std::string submitted_profile;
+  std::string origin;
   current_fetch = (mining_mode == MINING_MODE_SERVER) ? PROGRAMS_TO_FETCH : 0;
   num_processed = 0;
   num_removed = 0;
   while (true) {
     // if queue is empty: fetch or generate a new program
+    origin = "mutator";
     if (progs.empty()) {
       // server mode: try to fetch a program
       if (mining_mode == MINING_MODE_SERVER) {
@@ -215,6 +222,8 @@ void Miner::runMineLoop() {
           if (program.ops.empty() && multi_generator->isFinished()) {
             break;
           }
+          origin = "v" + std::to_string(
+                             multi_generator->getCurrentConfig().version);
           progs.push(std::move(program));
         } else {
           // mutate base program
@@ -240,10 +249,14 @@ void Miner::runMineLoop() {
         }
       }
 
-      // otherwise match sequences
+      // otherwise match sequences, unless the program is trivial
       if (seq_programs.empty()) {
-        seq_programs = manager->getFinder().findSequence(
-            program, norm_seq, manager->getSequences());
+        if (isTrivial(program)) {
+          num_filtered_per_generator[origin]++;
+        } else {
+          seq_programs = manager->getFinder().findSequence(
+              program, norm_seq, manager->getSequences());
+        }
       }
 
       // validate matched programs and update existing programs
@@ -288,6 +301,13 @@ void Miner::runMineLoop() {
                                            NUM_MUTATIONS / 2, progs);
             mutator->mutateCopiesRandom(update_result.program,
                                         NUM_MUTATIONS / 2, progs);
+            if (mutation_parents.size() >= MAX_BACKLOG) {
+              mutation_parents.clear();
+              if (!base_program.ops.empty()) {
+                mutation_parents.insert(base_program);
+              }
+            }
+            mutation_parents.insert(update_result.program);
           }
         }
       }
@@ -307,6 +327,7 @@ void Miner::runMineLoop() {
 
   // final progress message
   logProgress(false);
+  manager->getFinder().saveOutputCache();
 
   // report remaining cpu hours
   while (num_reported_hours < settings.num_mine_hours) {
@@ -350,9 +371,26 @@ bool Miner::checkRegularTasks() {
     labels.clear();
     labels["kind"] = "removed";
     entries.push_back({"programs", labels, static_cast<double>(num_removed)});
+    labels["kind"] = "filtered";
+    for (auto it : num_filtered_per_generator) {
+      labels["generator"] = it.first;
+      entries.push_back({"programs", labels, static_cast<double>(it.second)});
+    }
+    labels.clear();
+    labels["kind"] = "false_positive_rate";
+    for (const auto &m : manager->getFinder().getMatchers()) {
+      auto stats = m->getFilterStats();
+      if (stats.num_misses > 0) {
+        labels["matcher"] = m->getName();
+        entries.push_back(
+            {"matcher_filter", labels,
+             static_cast<double>(stats.num_false_positives) / stats.num_misses});
+      }
+    }
     Metrics::get().write(entries);
     num_new_per_user.clear();
     num_updated_per_user.clear();
+    num_filtered_per_generator.clear();
     num_removed = 0;
   }
 
@@ -380,6 +418,28 @@ void Miner::logProgress(bool report_slow) {
     buf << ", " << std::fixed << p << "%";
     progress = buf.str();
   }
+  const auto cache_stats = manager->getFinder().getOutputCacheStats(true);
+  if (cache_stats.first > 0) {
+    std::stringstream buf;
+    buf.precision(1);
+    buf << ", " << std::fixed << (100.0 * cache_stats.second / cache_stats.first)
+        << "% known outputs";
+    progress += buf.str();
+  }
+  const auto estimate_stats =
+      manager->getFinder().getStepEstimateStats(true);
+  if (estimate_stats.num_estimates > 0) {
+    const double avg_time =
+        std::chrono::duration<double, std::micro>(estimate_stats.time)
+            .count() /
+        estimate_stats.num_estimates;
+    std::stringstream buf;
+    buf.precision(1);
+    buf << ", " << std::fixed
+        << (100.0 * estimate_stats.num_skipped / estimate_stats.num_estimates)
+        << "% exceeding step estimates (" << avg_time << "us per estimate)";
+    progress += buf.str();
+  }
   if (num_processed) {
     Log::get().info("Processed " + std::to_string(num_processed) + " programs" +
                     progress);
@@ -389,6 +449,15 @@ void Miner::logProgress(bool report_slow) {
   }
 }
 
+bool Miner::isTrivial(const Program &program) {
+  // mutants that are identical to their parent programs
+  if (mutation_parents.find(program) != mutation_parents.end()) {
+    return true;
+  }
+  // programs that are independent of the input or affine functions of it
+  return Analyzer::isTrivial(program);
+}
+
 void Miner::reportCPUHour() {
   if (Setup::shouldReportCPUHours() && settings.report_cpu_hours) {
     api_client->postCPUHour();
@@ -2,6 +2,7 @@
 
 #include <map>
 #include <memory>
+#include <set>
 
 #include "eval/optimizer.hpp"
 #include "lang/program.hpp"
@@ -47,6 +48,8 @@ class Miner {
 
   void logProgress(bool report_slow);
 
+  bool isTrivial(const Program &program);
+
   void reportCPUHour();
 
   static const std::string ANONYMOUS;
@@ -75,4 +78,6 @@ class Miner {
   int64_t current_fetch;
   std::map<std::string, int64_t> num_new_per_user;
   std::map<std::string, int64_t> num_updated_per_user;
+  std::map<std::string, int64_t> num_filtered_per_generator;
+  std::set<Program> mutation_parents;
 };
@@ -1,5 +1,7 @@
 #include "mine/reducer.hpp"
 
+#include <algorithm>
+
 #include "eval/semantics.hpp"
 #include "sys/util.hpp"
 
@@ -112,3 +114,133 @@ int64_t Reducer::digit(Sequence &seq, int64_t num_digits) {
   //          + std::to_string( index ) );
   return index.asInt();
 }
+
+void ReductionContext::addDigitBase(int64_t num_digits) {
+  for (const auto &c : digit_counts) {
+    if (c.first == num_digits) {
+      return;
+    }
+  }
+  digit_counts.push_back({num_digits, std::vector<size_t>(num_digits)});
+}
+
+Number gcdNonZero(const Number &g, const Number &v) {
+  if (v == Number::ZERO || g == Number::ONE) {
+    return g;
+  }
+  const auto a = Semantics::abs(v);
+  return (g == Number::ZERO) ? a : Semantics::gcd(g, a);
+}
+
+void ReductionContext::init(const Sequence &seq) {
+  has_inf = false;
+  has_negative = false;
+  min = Number::INF;
+  gcd_abs = Number::ZERO;
+  gcd_diff = Number::ZERO;
+  for (auto &c : digit_counts) {
+    std::fill(c.second.begin(), c.second.end(), 0);
+  }
+  for (size_t i = 0; i < seq.size(); i++) {
+    const auto &v = seq[i];
+    if (v == Number::INF) {
+      has_inf = true;
+      return;
+    }
+    if (v < Number::ZERO) {
+      has_negative = true;
+    }
+    if (min == Number::INF || v < min) {
+      min = v;
+    }
+    gcd_abs = gcdNonZero(gcd_abs, v);
+    if (i > 0) {
+      gcd_diff = gcdNonZero(gcd_diff, Semantics::sub(v, seq[0]));
+    }
+    for (auto &c : digit_counts) {
+      c.second[((Semantics::mod(v, c.first)).asInt() + c.first) % c.first]++;
+    }
+  }
+}
+
+line_t Reducer::linear1(const Sequence &seq, const ReductionContext &ctx,
+                        Sequence &result) {
+  line_t line;
+  if (seq.empty() || ctx.has_inf) {
+    result = seq;
+    line.offset = truncate(result);
+    line.factor = shrink(result);
+    return line;
+  }
+  // truncate and then shrink
+  Number g = ctx.gcd_abs;
+  line.offset = Number::ZERO;
+  if (!ctx.has_negative) {
+    line.offset = ctx.min;
+    g = gcdNonZero(ctx.gcd_diff, Semantics::sub(seq[0], ctx.min));
+  }
+  line.factor = (g == Number::ZERO) ? Number::ONE : g;
+  result.resize(seq.size());
+  for (size_t i = 0; i < seq.size(); i++) {
+    result[i] = Semantics::sub(seq[i], line.offset);
+    if (line.factor != Number::ONE) {
+      result[i] = Semantics::div(result[i], line.factor);
+    }
+  }
+  return line;
+}
+
+line_t Reducer::linear2(const Sequence &seq, const ReductionContext &ctx,
+                        Sequence &result) {
+  line_t line;
+  if (seq.empty() || ctx.has_inf) {
+    result = seq;
+    line.factor = shrink(result);
+    line.offset = truncate(result);
+    return line;
+  }
+  // shrink and then truncate
+  line.factor =
+      (ctx.gcd_abs == Number::ZERO) ? Number::ONE : ctx.gcd_abs;
+  line.offset = ctx.has_negative ? Number::ZERO
+                                 : Semantics::div(ctx.min, line.factor);
+  result.resize(seq.size());
+  for (size_t i = 0; i < seq.size(); i++) {
+    result[i] = seq[i];
+    if (line.factor != Number::ONE) {
+      result[i] = Semantics::div(result[i], line.factor);
+    }
+    result[i] = Semantics::sub(result[i], line.offset);
+  }
+  return line;
+}
+
+int64_t Reducer::digit(const Sequence &seq, const ReductionContext &ctx,
+                       int64_t num_digits, Sequence &result) {
+  const std::vector<size_t> *count = nullptr;
+  for (const auto &c : ctx.digit_counts) {
+    if (c.first == num_digits) {
+      count = &c.second;
+    }
+  }
+  if (!count || ctx.has_inf) {
+    result = seq;
+    return digit(result, num_digits);
+  }
+  int64_t index = 0;
+  size_t max = 0;
+  for (int64_t i = 0; i < num_digits; i++) {
+    if ((*count)[i] > max) {
+      index = i;
+      max = (*count)[i];
+    }
+  }
+  const Number d(num_digits);
+  const Number n(index);
+  result.resize(seq.size());
+  for (size_t i = 0; i < seq.size(); i++) {
+    result[i] = Semantics::mod(
+        Semantics::add(Semantics::mod(Semantics::sub(seq[i], n), d), d), d);
+  }
+  return index;
+}
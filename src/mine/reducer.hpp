@@ -1,6 +1,7 @@
 #pragma once
 
 #include "math/sequence.hpp"
+#include "mine/extender.hpp"
 
 struct delta_t {
   int64_t delta;
@@ -8,6 +9,30 @@ struct delta_t {
   Number factor;
 };
 
+// Statistics of a sequence that are needed by several reductions. They are
+// computed in a single scan over the terms, so that the reductions only need
+// to write the reduced terms. The context also holds a reusable buffer for
+// the reduced terms.
+class ReductionContext {
+ public:
+  void addDigitBase(int64_t num_digits);
+
+  void init(const Sequence &seq);
+
+  // no reductions based on the statistics if terms are infinite
+  bool has_inf;
+  bool has_negative;
+  Number min;
+  // greatest common divisors of the absolute values of the terms and of the
+  // differences to the first term (zero if all are zero)
+  Number gcd_abs;
+  Number gcd_diff;
+  // number of terms per digit for every registered base
+  std::vector<std::pair<int64_t, std::vector<size_t>>> digit_counts;
+
+  Sequence buffer;
+};
+
 class Reducer {
  public:
   static Number truncate(Sequence &seq);
@@ -17,4 +42,16 @@ class Reducer {
   static delta_t delta(Sequence &seq, int64_t max_delta);
 
   static int64_t digit(Sequence &seq, int64_t num_digits);
+
+  // The following functions produce the same results as the ones above. They
+  // use the statistics of the context and write the reduced terms to result.
+
+  static line_t linear1(const Sequence &seq, const ReductionContext &ctx,
+                        Sequence &result);
+
+  static line_t linear2(const Sequence &seq, const ReductionContext &ctx,
+                        Sequence &result);
+
+  static int64_t digit(const Sequence &seq, const ReductionContext &ctx,
+                       int64_t num_digits, Sequence &result);
 };
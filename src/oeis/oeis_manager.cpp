@@ -15,9 +15,11 @@
 #include "eval/optimizer.hpp"
 #include "form/formula_gen.hpp"
 #include "lang/comments.hpp"
+#include "lang/program_store.hpp"
 #include "lang/program_util.hpp"
 #include "lang/subprogram.hpp"
 #include "mine/config.hpp"
+#include "mine/fingerprint_index.hpp"
 #include "mine/stats.hpp"
 #include "oeis/oeis_list.hpp"
 #include "oeis/oeis_program.hpp"
@@ -44,6 +46,7 @@ OeisManager::OeisManager(const Settings &settings,
       update_programs(false),
       optimizer(settings),
       minimizer(settings),
+      terms_provider(settings, sequences),
       loaded_count(0),
       total_count(0),
       stats_home(stats_home.empty()
@@ -56,6 +59,9 @@ void OeisManager::load() {
     return;
   }
 
+  // drop programs that were updated by other processes
+  ProgramStore::get().refresh(true);
+
   // first load the custom sequences lists (needs no lock)
   const std::string oeis_dir = Setup::getProgramsHome() + "oeis" + FILE_SEP;
   OeisList::loadList(oeis_dir + "deny.txt", deny_list);
@@ -116,6 +122,11 @@ void OeisManager::load() {
   Log::get().info("Loaded " + std::to_string(loaded_count) + "/" +
                   std::to_string(total_count) + " sequences in " + buf.str() +
                   "s");
+
+  // optionally use the OEIS terms for seq calls
+  if (Setup::getSetupFlag("LODA_SEED_SEQ_TERMS", false)) {
+    evaluator.setSeqTermsProvider(&terms_provider);
+  }
 }
 
 void OeisManager::loadData() {
@@ -241,18 +252,56 @@ Finder &OeisManager::getFinder() {
     // generate stats is needed
     getStats();
 
+    // collect the sequences to match; the random back off due to invalid
+    // matches is applied afterwards to be able to reuse the indexes
     ignore_list.clear();
+    std::vector<size_t> ids;
+    uint64_t key = FingerprintIndex::combine(0, settings.num_terms);
     for (auto &seq : sequences) {
       if (seq.id == 0) {
         continue;
       }
-      if (shouldMatch(seq)) {
-        auto seq_norm = seq.getTerms(settings.num_terms);
-        finder.insert(seq_norm, seq.id);
+      if (shouldMatch(seq, false)) {
+        ids.push_back(seq.id);
+        key = FingerprintIndex::combine(key, seq.id);
+        key = FingerprintIndex::combine(
+            key, FingerprintIndex::fingerprint(seq.getTerms(settings.num_terms)));
       } else {
         ignore_list.insert(seq.id);
       }
     }
+
+    // load the matcher indexes or build and save them; the snapshots of
+    // different profiles are stored in different files
+    key = FingerprintIndex::combine(key, finder.getMatchersKey());
+    std::stringstream key_hex;
+    key_hex << std::hex << std::setw(16) << std::setfill('0') << key;
+    const std::string cache_dir = Setup::getLodaHome() + "cache" + FILE_SEP;
+    const std::string path = cache_dir + "matchers_" + key_hex.str() + ".bin";
+    const std::string outputs_path =
+        cache_dir + "outputs_" + key_hex.str() + ".bin";
+    pruneSnapshots(cache_dir, {path, outputs_path});
+    if (finder.loadIndexes(path, key)) {
+      Log::get().debug("Loaded matcher indexes from " + path);
+    } else {
+      for (auto id : ids) {
+        finder.insert(sequences[id].getTerms(settings.num_terms), id);
+      }
+      finder.saveIndexes(path, key);
+    }
+    finder.initPrefixIndex(ids.size());
+    for (auto id : ids) {
+      finder.insertPrefix(sequences[id].getTerms(settings.num_terms));
+    }
+    for (auto id : ids) {
+      if (!shouldMatch(sequences[id])) {
+        finder.remove(sequences[id].getTerms(settings.num_terms), id);
+        ignore_list.insert(id);
+      }
+    }
+    if (settings.persist_output_cache) {
+      finder.loadOutputCache(outputs_path, key);
+    }
     finder_initialized = true;
 
     // print summary
@@ -265,7 +314,28 @@ Finder &OeisManager::getFinder() {
   return finder;
 }
 
-bool OeisManager::shouldMatch(const OeisSequence &seq) const {
+void OeisManager::pruneSnapshots(const std::string &cache_dir,
+                                 const std::set<std::string> &keep) {
+  if (!isDir(cache_dir)) {
+    return;
+  }
+  std::error_code ec;
+  for (const auto &f : std::filesystem::directory_iterator(cache_dir, ec)) {
+    const auto name = f.path().filename().string();
+    const auto p = f.path().string();
+    const bool is_snapshot =
+        (name.rfind("matchers_", 0) == 0 || name.rfind("outputs_", 0) == 0) &&
+        f.path().extension() == ".bin";
+    if (is_snapshot && keep.find(p) == keep.end() &&
+        getFileAgeInDays(p) > MAX_SNAPSHOT_AGE_IN_DAYS) {
+      Log::get().debug("Removing \"" + p + "\"");
+      std::filesystem::remove(f.path(), ec);
+    }
+  }
+}
+
+bool OeisManager::shouldMatch(const OeisSequence &seq,
+                              bool check_invalid_matches) const {
   if (seq.id == 0) {
     return false;
   }
@@ -278,7 +348,8 @@ bool OeisManager::shouldMatch(const OeisSequence &seq) const {
   // too many invalid matches already?
   bool too_many_matches = false;
   auto it = invalid_matches_map.find(seq.id);
-  if (it != invalid_matches_map.end() && it->second > 0 &&
+  if (check_invalid_matches && it != invalid_matches_map.end() &&
+      it->second > 0 &&
       (Random::get().gen() % it->second) >= 100)  // magic number
   {
     too_many_matches = true;
@@ -393,6 +464,7 @@ void OeisManager::update(bool force) {
       Log::get().info(msg);
       // update programs repository using git pull
       Setup::pullProgramsHome();
+      ProgramStore::get().clear();
     }
 
     // touch marker file to track the age (even in server mode)
@@ -492,6 +564,17 @@ void OeisManager::generateStats(int64_t age_in_days) {
   stats->finalize();
   stats->save(stats_home);
 
+  // write the snapshot of the called programs, which is shared by the miners
+  std::vector<int64_t> called_ids;
+  for (size_t id = 0; id < stats->program_usages.size(); id++) {
+    if (stats->program_usages[id] > 0) {
+      called_ids.push_back(id);
+    }
+  }
+  const size_t num_snapshot = ProgramStore::get().writeSnapshot(called_ids);
+  Log::get().debug("Wrote program snapshot with " +
+                   std::to_string(num_snapshot) + " programs");
+
   // done
   Log::get().info("Finished stats generation for " +
                   std::to_string(num_processed) + " programs");
@@ -708,6 +791,7 @@ void OeisManager::updateDependentOffset(size_t id, size_t used_id,
   if (updated) {
     optimizer.optimize(p);
     dumpProgram(id, p, path, submitted_by);
+    terms_provider.invalidate(id);
   }
 }
 
@@ -761,6 +845,7 @@ void OeisManager::dumpProgram(size_t id, Program &p, const std::string &file,
   std::ofstream out(file);
   ProgramUtil::print(p, out);
   out.close();
+  ProgramStore::get().invalidate(id);
 }
 
 void OeisManager::alert(Program p, size_t id, const std::string &prefix,
@@ -887,6 +972,7 @@ update_program_result_t OeisManager::updateProgram(
   auto delta = updateProgramOffset(id, result.program);
   optimizer.optimize(result.program);
   dumpProgram(id, result.program, target_file, submitted_by);
+  terms_provider.invalidate(id);
   if (is_server) {
     updateAllDependentOffset(id, delta);
   }
@@ -978,6 +1064,7 @@ bool OeisManager::maintainProgram(size_t id, bool eval) {
         optimizer.optimize(updated);
       }
       dumpProgram(s.id, updated, file_name, submitted_by);
+      terms_provider.invalidate(s.id);
       updateAllDependentOffset(s.id, delta);
     } catch (const std::exception &e) {
       is_okay = false;
@@ -988,6 +1075,8 @@ bool OeisManager::maintainProgram(size_t id, bool eval) {
     // send alert and remove file
     alert(program, id, "Removed invalid", "danger", "");
     remove(file_name.c_str());
+    ProgramStore::get().invalidate(id);
+    terms_provider.invalidate(id);
   }
 
   return is_okay;
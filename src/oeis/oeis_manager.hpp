@@ -1,5 +1,7 @@
 #pragma once
 
+#include <set>
+
 #include "eval/evaluator.hpp"
 #include "eval/minimizer.hpp"
 #include "eval/optimizer.hpp"
@@ -8,6 +10,7 @@
 #include "mine/finder.hpp"
 #include "mine/stats.hpp"
 #include "oeis/oeis_sequence.hpp"
+#include "oeis/oeis_terms.hpp"
 #include "sys/util.hpp"
 
 enum class OverwriteMode { NONE, ALL, AUTO };
@@ -23,6 +26,9 @@ struct update_program_result_t {
 
 class OeisManager {
  public:
+  // matcher snapshots of other profiles are removed after this age
+  static constexpr int64_t MAX_SNAPSHOT_AGE_IN_DAYS = 7;
+
   explicit OeisManager(const Settings& settings,
                        const std::string& stats_home = "");
 
@@ -59,7 +65,11 @@ class OeisManager {
 
   void loadOffsets();
 
-  bool shouldMatch(const OeisSequence& seq) const;
+  static void pruneSnapshots(const std::string& cache_dir,
+                             const std::set<std::string>& keep);
+
+  bool shouldMatch(const OeisSequence& seq,
+                   bool check_invalid_matches = true) const;
 
   void generateStats(int64_t age_in_days);
 
@@ -86,6 +96,7 @@ class OeisManager {
   Optimizer optimizer;
   Minimizer minimizer;
   std::vector<OeisSequence> sequences;
+  OeisTermsProvider terms_provider;
 
   std::unordered_set<size_t> deny_list;
   std::unordered_set<size_t> overwrite_list;
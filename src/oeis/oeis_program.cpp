@@ -5,6 +5,7 @@
 #include "lang/analyzer.hpp"
 #include "lang/comments.hpp"
 #include "lang/parser.hpp"
+#include "lang/program_store.hpp"
 #include "lang/program_util.hpp"
 #include "lang/subprogram.hpp"
 #include "oeis/oeis_sequence.hpp"
@@ -38,13 +39,12 @@ void collectPrograms(const Program &p, std::set<Program> &collected) {
     if (op.type == Operation::Type::SEQ &&
         op.source.type == Operand::Type::CONSTANT) {
       auto id = op.source.value.asInt();
-      auto path = ProgramUtil::getProgramPath(id);
       try {
-        Parser parser;
-        auto p2 = parser.parse(path);
-        collectPrograms(p2, collected);
+        auto p2 = ProgramStore::get().getProgram(id);
+        collectPrograms(*p2, collected);
       } catch (const std::exception &) {
-        Log::get().warn("Referenced program not found: " + path);
+        Log::get().warn("Referenced program not found: " +
+                        ProgramStore::getProgramPath(id));
       }
     }
   }
@@ -0,0 +1,102 @@
+#include "oeis/oeis_terms.hpp"
+
+#include "lang/program_store.hpp"
+#include "lang/program_util.hpp"
+#include "oeis/oeis_program.hpp"
+#include "sys/log.hpp"
+
+OeisTermsProvider::OeisTermsProvider(const Settings &settings,
+                                     const std::vector<OeisSequence> &sequences)
+    : sequences(sequences),
+      interpreter(settings),
+      inc_evaluator(interpreter),
+      store_version(ProgramStore::get().getVersion()) {}
+
+bool OeisTermsProvider::getTerm(int64_t id, const Number &arg,
+                                std::pair<Number, size_t> &result) {
+  const auto &entry = getEntry(id);
+  Number index(arg);
+  index -= Number(entry.offset);
+  if (index < Number::ZERO ||
+      !(index < Number(static_cast<int64_t>(entry.steps.size())))) {
+    return false;
+  }
+  const auto i = index.asInt();
+  result.first = entry.terms[i];
+  result.second = entry.steps[i];
+  return true;
+}
+
+void OeisTermsProvider::invalidate(int64_t id) {
+  // the dependencies are computed using the cached (old) programs
+  for (auto it = steps_table.begin(); it != steps_table.end();) {
+    const auto &deps = interpreter.getProgramDeps(it->first);
+    if (deps.find(id) != deps.end()) {
+      it = steps_table.erase(it);
+    } else {
+      it++;
+    }
+  }
+  interpreter.clearCaches();
+  // the program store was already updated by the caller
+  store_version = ProgramStore::get().getVersion();
+}
+
+const OeisTermsProvider::Entry &OeisTermsProvider::getEntry(int64_t id) {
+  // recompute everything if program files were updated
+  const auto version = ProgramStore::get().getVersion();
+  if (version != store_version) {
+    steps_table.clear();
+    interpreter.clearCaches();
+    store_version = version;
+  }
+  auto it = steps_table.find(id);
+  if (it != steps_table.end()) {
+    return it->second;
+  }
+  auto &entry = steps_table[id];
+  if (id <= 0 || id >= static_cast<int64_t>(sequences.size()) ||
+      sequences[id].id != static_cast<size_t>(id)) {
+    return entry;
+  }
+  std::shared_ptr<const Program> program;
+  try {
+    program = ProgramStore::get().getProgram(id);
+  } catch (const std::exception &) {
+    return entry;
+  }
+  const auto &p = *program;
+
+  // only use the terms that are already loaded (no b-file download)
+  const auto terms = sequences[id].getTerms(sequences[id].existingNumTerms());
+  const size_t num_terms =
+      std::min(OeisProgram::getNumRequiredTerms(p), terms.size());
+  entry.offset = ProgramUtil::getOffset(p);
+
+  // evaluate the called program and record the steps of the matching prefix
+  const bool use_inc_eval = inc_evaluator.init(p);
+  std::pair<Number, size_t> result;
+  Memory mem;
+  for (size_t i = 0; i < num_terms; i++) {
+    try {
+      if (use_inc_eval) {
+        result = inc_evaluator.next();
+      } else {
+        mem.clear();
+        mem.set(Program::INPUT_CELL, entry.offset + static_cast<int64_t>(i));
+        result.second = interpreter.run(p, mem, id);
+        result.first = mem.get(Program::OUTPUT_CELL);
+      }
+    } catch (const std::exception &) {
+      break;
+    }
+    if (result.first != terms[i]) {
+      break;
+    }
+    entry.terms.push_back(result.first);
+    entry.steps.push_back(result.second);
+  }
+  Log::get().debug("Verified " + std::to_string(entry.steps.size()) +
+                   " terms of " + ProgramUtil::idStr(id) + " for seq calls");
+  return entry;
+}
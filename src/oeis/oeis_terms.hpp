@@ -0,0 +1,41 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "eval/evaluator_inc.hpp"
+#include "eval/interpreter.hpp"
+#include "oeis/oeis_sequence.hpp"
+
+// Provides terms of called sequences from the OEIS data instead of evaluating
+// the called programs. Terms are served only in the range in which the called
+// program was verified to match the OEIS terms. The reported steps are taken
+// from a steps table, which is computed once per called program on first use.
+// Hence, the results are identical to the ones of a regular evaluation.
+class OeisTermsProvider : public SeqTermsProvider {
+ public:
+  OeisTermsProvider(const Settings &settings,
+                    const std::vector<OeisSequence> &sequences);
+
+  bool getTerm(int64_t id, const Number &arg,
+               std::pair<Number, size_t> &result) override;
+
+  // Remove the entries of a program and of the programs that call it.
+  void invalidate(int64_t id);
+
+  size_t size() const { return steps_table.size(); }
+
+ private:
+  struct Entry {
+    int64_t offset = 0;
+    Sequence terms;
+    std::vector<size_t> steps;
+  };
+
+  const Entry &getEntry(int64_t id);
+
+  const std::vector<OeisSequence> &sequences;
+  Interpreter interpreter;
+  IncrementalEvaluator inc_evaluator;
+  std::unordered_map<int64_t, Entry> steps_table;
+  size_t store_version;
+};
@@ -23,7 +23,9 @@
 #include <psapi.h>
 #include <windows.h>
 #else
+#include <fcntl.h>
 #include <sys/file.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -309,6 +311,81 @@ bool getJBool(jute::jValue &v, const std::string &key, bool def) {
   return def;
 }
 
+bool appendToFile(const std::string &path, const void *data, size_t size) {
+#ifdef _WIN64
+  std::ofstream out(path, std::ios::binary | std::ios::app);
+  if (!out) {
+    return false;
+  }
+  out.write(static_cast<const char *>(data), size);
+  return out.good();
+#else
+  int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  auto written = write(fd, data, size);
+  close(fd);
+  return written == static_cast<ssize_t>(size);
+#endif
+}
+
+MappedFile::MappedFile(const std::string &path)
+    : path(path), ptr(nullptr), length(0), file_id(0) {}
+
+MappedFile::~MappedFile() { unmap(); }
+
+bool MappedFile::refresh() {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    return false;
+  }
+  const size_t new_length = st.st_size;
+  const uint64_t new_file_id = st.st_ino;
+  if (new_length == length && new_file_id == file_id) {
+    return false;
+  }
+  unmap();
+  file_id = new_file_id;
+  if (new_length == 0) {
+    return true;
+  }
+#ifdef _WIN64
+  std::ifstream in(path, std::ios::binary);
+  buffer.resize(new_length);
+  in.read(&buffer[0], new_length);
+  buffer.resize(in.gcount());
+  ptr = buffer.data();
+  length = buffer.size();
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return true;
+  }
+  void *addr = mmap(nullptr, new_length, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED) {
+    Log::get().warn("Cannot map file " + path);
+    return true;
+  }
+  ptr = static_cast<const char *>(addr);
+  length = new_length;
+#endif
+  return true;
+}
+
+void MappedFile::unmap() {
+#ifdef _WIN64
+  buffer.clear();
+#else
+  if (ptr) {
+    munmap(const_cast<char *>(ptr), length);
+  }
+#endif
+  ptr = nullptr;
+  length = 0;
+}
+
 FolderLock::FolderLock(std::string folder) {
   // obtain lock
   ensureTrailingFileSep(folder);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 #include <map>
 #include <string>
@@ -58,6 +59,49 @@ double getJDouble(jute::jValue &v, const std::string &key, double def);
 
 bool getJBool(jute::jValue &v, const std::string &key, bool def);
 
+// Appends binary data to a file. On POSIX systems, the data is written using a
+// single write call in append mode, which makes concurrent appends of small
+// records from multiple processes safe.
+bool appendToFile(const std::string &path, const void *data, size_t size);
+
+// Read-only memory mapping of a file that can be shared between processes.
+// The mapping can be refreshed when the file grows, e.g. because another
+// process appended data to it. On Windows, the file content is read into a
+// buffer instead.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string &path);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Update the mapping if the file size changed or the file was replaced.
+  // Returns true if the mapped content was changed.
+  bool refresh();
+
+  const char *data() const { return ptr; }
+
+  size_t size() const { return length; }
+
+  // identifier of the mapped file, which changes if the file is replaced
+  // (not supported on Windows)
+  uint64_t getFileId() const { return file_id; }
+
+ private:
+  void unmap();
+
+  const std::string path;
+  const char *ptr;
+  size_t length;
+  uint64_t file_id;
+#ifdef _WIN64
+  std::string buffer;
+#endif
+};
+
 class FolderLock {
  public:
   explicit FolderLock(std::string folder);
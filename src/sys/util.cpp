@@ -36,8 +36,13 @@ Settings::Settings()
       with_deps(false),
       parallel_mining(false),
       report_cpu_hours(true),
+      use_term_store(false),
+      use_output_cache(false),
+      persist_output_cache(false),
       num_miner_instances(0),
       num_mine_hours(0),
+      num_eval_threads(1),
+      num_find_threads(1),
       print_as_b_file(false) {}
 
 enum class Option {
@@ -50,6 +55,7 @@ enum class Option {
   NUM_MINE_HOURS,
   MINER_PROFILE,
   EXPORT_FORMAT,
+  CHECKPOINT_FILE,
   LOG_LEVEL
 };
 
@@ -91,6 +97,7 @@ std::vector<std::string> Settings::parseArgs(int argc, char *argv[]) {
         case Option::LOG_LEVEL:
         case Option::MINER_PROFILE:
         case Option::EXPORT_FORMAT:
+        case Option::CHECKPOINT_FILE:
         case Option::NONE:
           break;
       }
@@ -101,6 +108,9 @@ std::vector<std::string> Settings::parseArgs(int argc, char *argv[]) {
     } else if (option == Option::EXPORT_FORMAT) {
       export_format = arg;
       option = Option::NONE;
+    } else if (option == Option::CHECKPOINT_FILE) {
+      checkpoint_file = arg;
+      option = Option::NONE;
     } else if (option == Option::LOG_LEVEL) {
       if (arg == "debug") {
         Log::get().level = Log::Level::DEBUG;
@@ -143,6 +153,8 @@ std::vector<std::string> Settings::parseArgs(int argc, char *argv[]) {
         option = Option::NUM_MINE_HOURS;
       } else if (opt == "b") {
         print_as_b_file = true;
+      } else if (opt == "r") {
+        option = Option::CHECKPOINT_FILE;
       } else if (opt == "-no-report-cpu-hours") {
         report_cpu_hours = false;
       } else if (opt == "l") {
@@ -193,6 +205,10 @@ void Settings::printArgs(std::vector<std::string> &args) {
   if (print_as_b_file) {
     args.push_back("-b");
   }
+  if (!checkpoint_file.empty()) {
+    args.push_back("-r");
+    args.push_back(checkpoint_file);
+  }
 }
 
 AdaptiveScheduler::AdaptiveScheduler(int64_t target_seconds)
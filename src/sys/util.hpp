@@ -30,14 +30,22 @@ class Settings {
   bool with_deps;
   bool parallel_mining;
   bool report_cpu_hours;
+  bool use_term_store;
+  bool use_output_cache;
+  bool persist_output_cache;
   int64_t num_miner_instances;
   int64_t num_mine_hours;
+  int64_t num_eval_threads;
+  int64_t num_find_threads;
   std::string miner_profile;
   std::string export_format;
 
   // flag for printing evaluation results in b-file format
   bool print_as_b_file;
 
+  // checkpoint file for resuming the generation of b-files
+  std::string checkpoint_file;
+
   Settings();
 
   std::vector<std::string> parseArgs(int argc, char *argv[]);
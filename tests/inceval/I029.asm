@@ -0,0 +1,11 @@
+; 0,2,5,9,14,20,27,35,44,54,65,77,90,104,119,135,152,170,189,209
+mov $1,$0
+lpb $0
+  add $2,$0
+  sub $0,1
+lpe
+lpb $1
+  add $2,1
+  sub $1,1
+lpe
+mov $0,$2
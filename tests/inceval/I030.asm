@@ -0,0 +1,9 @@
+; 0,1,1,2,3,5,8,13,21,34,55,89,144,233,377,610,987,1597,2584,4181
+mov $3,1
+lpb $0,2
+  sub $0,1
+  mov $2,$1
+  add $1,$3
+  mov $3,$2
+lpe
+mov $0,$1
@@ -0,0 +1,15 @@
+; 0,0,2,6,12,20,30,42,56,72,90,110,132,156,182,210,240,272,306,342
+mov $2,$0
+lpb $0
+  sub $0,1
+  add $1,$0
+lpe
+lpb $2
+  sub $2,1
+  mov $3,$2
+  lpb $3
+    sub $3,1
+    add $1,1
+  lpe
+lpe
+mov $0,$1